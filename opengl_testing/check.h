@@ -0,0 +1,18 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+// The tests under opengl_testing count failed checks instead of stopping at the first one, main returns the count
+
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(condition)                                                          \
+    do {                                                                          \
+        if (!(condition)) {                                                       \
+            fprintf(stderr, "FAIL: %s:%d: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                           \
+        }                                                                         \
+    } while (0)
+
+#endif
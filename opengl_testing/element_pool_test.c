@@ -0,0 +1,111 @@
+// Checks the generational handles of pooled elements: releasing a slot bumps its generation, stale handles
+// are rejected, and freed slots are handed out again before the pool grows.
+
+#include "../src/guilay.h"
+#include "../src/common/elementpool.h"
+#include "check.h"
+
+#include <stdio.h>
+
+static void TestPool() {
+    ElementPool pool;
+    InitElementPool(&pool);
+
+    ElementSlot* slot = AcquireElementSlot(&pool, TEXT, ELEMENT_SLOT_NONE);
+    CHECK(slot != NULL);
+    if (slot == NULL) return;
+    ElementHandle first = GetSlotHandle(slot);
+    CHECK(first.generation != 0);
+    CHECK(ResolveElementHandle(&pool, first) == slot);
+
+    ReleaseElementSlot(&pool, first.index);
+    CHECK(slot->generation == first.generation + 1);
+    CHECK(ResolveElementHandle(&pool, first) == NULL);
+    CHECK(pool.live == 0);
+
+    // Releasing twice must not put the slot on the free list twice
+    ReleaseElementSlot(&pool, first.index);
+    CHECK(slot->generation == first.generation + 1);
+
+    ElementSlot* reused = AcquireElementSlot(&pool, SECTION, ELEMENT_SLOT_NONE);
+    CHECK(reused == slot);
+    CHECK(pool.count == 1);
+    ElementHandle second = GetSlotHandle(reused);
+    CHECK(second.index == first.index && second.generation == first.generation + 1);
+    CHECK(ResolveElementHandle(&pool, first) == NULL);
+    CHECK(ResolveElementHandle(&pool, second) == reused);
+
+    // Slots are reused newest freed first, and only then does the pool grow
+    ElementSlot* slots[3];
+    for (int i = 0; i < 3; i++) slots[i] = AcquireElementSlot(&pool, TEXT, ELEMENT_SLOT_NONE);
+    CHECK(pool.count == 4);
+    ReleaseElementSlot(&pool, slots[0]->element.slot);
+    ReleaseElementSlot(&pool, slots[2]->element.slot);
+    CHECK(AcquireElementSlot(&pool, TEXT, ELEMENT_SLOT_NONE) == slots[2]);
+    CHECK(AcquireElementSlot(&pool, TEXT, ELEMENT_SLOT_NONE) == slots[0]);
+    CHECK(pool.count == 4);
+    CHECK(AcquireElementSlot(&pool, TEXT, ELEMENT_SLOT_NONE) != NULL);
+    CHECK(pool.count == 5);
+
+    // A handle that was never handed out
+    CHECK(ResolveElementHandle(&pool, (ElementHandle){1000, 1}) == NULL);
+    CHECK(ResolveElementHandle(&pool, NULL_ELEMENT) == NULL);
+
+    FreeElementPool(&pool);
+}
+
+static void TestWindowHandles() {
+    Window* window = CreateWindow((Vector2i){64, 64}, "element pool test");
+    CHECK(window != NULL);
+    if (window == NULL) return;
+
+    ElementHandle section = SpawnSection(window, NULL_ELEMENT, (Vector2){64, 64}, (Color){0, 0, 0, 255});
+    ElementHandle children[3];
+    for (int i = 0; i < 3; i++) {
+        children[i] = SpawnText(window, section, (Vector2){64, 16}, "row", 0.3f, (Color){255, 255, 255, 255});
+        CHECK(IsElementAlive(window, children[i]));
+    }
+
+    // Removing a section removes everything inside of it
+    RemoveElement(window, section);
+    CHECK(!IsElementAlive(window, section));
+    for (int i = 0; i < 3; i++) {
+        CHECK(!IsElementAlive(window, children[i]));
+        CHECK(GetElementData(window, children[i]) == NULL);
+    }
+    CHECK(SpawnText(window, section, (Vector2){64, 16}, "row", 0.3f, (Color){255, 255, 255, 255}).generation == 0);
+
+    // The four freed slots come back with newer generations
+    ElementHandle again[4];
+    for (int i = 0; i < 4; i++) {
+        again[i] = SpawnText(window, NULL_ELEMENT, (Vector2){64, 16}, "again", 0.3f, (Color){255, 255, 255, 255});
+        CHECK(again[i].index < 4);
+        CHECK(IsElementAlive(window, again[i]));
+    }
+    for (int i = 0; i < 4; i++) {
+        ElementHandle old = i == 0 ? section : children[i - 1];
+        for (int j = 0; j < 4; j++) {
+            if (again[j].index == old.index) CHECK(again[j].generation > old.generation);
+        }
+    }
+
+    // A stale handle must not remove whatever took over its slot
+    RemoveElement(window, children[0]);
+    for (int i = 0; i < 4; i++) CHECK(IsElementAlive(window, again[i]));
+
+    DestroyWindow(window);
+}
+
+int main() {
+    TestPool();
+
+    if (GuilayInitBackend(GUILAY_BACKEND_SOFTWARE)) {
+        fprintf(stderr, "FAIL: backend did not start\n");
+        return 1;
+    }
+    TestWindowHandles();
+    GuilayExit();
+
+    if (failures == 0) printf("element pool test passed\n");
+    return failures != 0;
+}
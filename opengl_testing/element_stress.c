@@ -0,0 +1,95 @@
+// Adds a million elements to one window one at a time, so the element array keeps doubling, then draws them.
+// Fails when an element is lost on the way: the frame has to see every one of them and hit testing has to find
+// the right ones. Run from the repository root so the font is found.
+
+#include "../src/guilay.h"
+#include "../src/common/elements.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define ELEMENT_COUNT 1000000
+#define ROW_HEIGHT 20
+#define WINDOW_WIDTH 200
+#define WINDOW_HEIGHT 600
+
+static double Now() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main() {
+    if (GuilayInitBackend(GUILAY_BACKEND_SOFTWARE)) return 1;
+    Window* window = CreateWindow((Vector2i){WINDOW_WIDTH, WINDOW_HEIGHT}, "element stress");
+    Element** elements = malloc(ELEMENT_COUNT * sizeof(Element*));
+    if (window == NULL || elements == NULL || LoadAssets(window)) {
+        fprintf(stderr, "FAIL: window did not open\n");
+        GuilayExit();
+        return 1;
+    }
+    SetWindowRenderMode(window, RENDER_ON_DEMAND);
+
+    double start = Now();
+    BeginWindowArena(window);
+    for (size_t i = 0; i < ELEMENT_COUNT; i++) {
+        Color color = {(uint8_t)i, (uint8_t)(i >> 8), (uint8_t)(i >> 16), 255};
+        elements[i] = CreateButtonElement(CreateButton((Vector2){WINDOW_WIDTH, ROW_HEIGHT}, color, NULL, NULL));
+        if (elements[i] == NULL) {
+            fprintf(stderr, "FAIL: ran out of memory at element %zu\n", i);
+            GuilayExit();
+            return 1;
+        }
+    }
+    EndWindowArena();
+    double created = Now() - start;
+
+    // Both halves should take about as long, appending stays amortized constant while the array doubles
+    start = Now();
+    for (size_t i = 0; i < ELEMENT_COUNT / 2; i++) AddElement(window, elements[i]);
+    double firstHalf = Now() - start;
+    start = Now();
+    for (size_t i = ELEMENT_COUNT / 2; i < ELEMENT_COUNT; i++) AddElement(window, elements[i]);
+    double secondHalf = Now() - start;
+
+    FillWindow(window, (Color){0, 0, 0, 255});
+    start = Now();
+    UpdateWindow(window);
+    double firstFrame = Now() - start;
+
+    InvalidateWindow(window);
+    start = Now();
+    UpdateWindow(window);
+    double redraw = Now() - start;
+
+    FrameStats stats = GetFrameStats(window);
+    printf("%d elements: created %.0f ms, appended %.0f + %.0f ms, first frame %.0f ms, redraw %.1f ms\n",
+           ELEMENT_COUNT, created * 1e3, firstHalf * 1e3, secondHalf * 1e3, firstFrame * 1e3, redraw * 1e3);
+    printf("%zu commands, %zu culled\n", stats.drawCommands, stats.culled);
+
+    int failures = 0;
+    size_t visible = WINDOW_HEIGHT / ROW_HEIGHT;
+    if (stats.drawCommands != visible) {
+        fprintf(stderr, "FAIL: %zu commands, expected one per visible row (%zu)\n", stats.drawCommands, visible);
+        failures++;
+    }
+    for (size_t row = 0; row < visible; row++) {
+        Element* hit = GetElementAt(window, (Vector2){WINDOW_WIDTH / 2.0f, row * ROW_HEIGHT + ROW_HEIGHT / 2.0f});
+        if (hit != elements[row]) {
+            fprintf(stderr, "FAIL: row %zu hit the wrong element\n", row);
+            failures++;
+            break;
+        }
+    }
+    // The last element has to be laid out below all the others
+    Rect last = elements[ELEMENT_COUNT - 1]->bounds;
+    if (last.position.y != (float)(ELEMENT_COUNT - 1) * ROW_HEIGHT) {
+        fprintf(stderr, "FAIL: the last element was laid out at %.0f\n", last.position.y);
+        failures++;
+    }
+
+    free(elements);
+    GuilayExit();
+    return failures != 0;
+}
@@ -0,0 +1,71 @@
+// 1000 labels of 1000 different colors, which have to end up in one draw call.
+// Color travels in the vertex stream, so it never splits a batch. Run from the repository root so the font is found.
+// Uses the software backend unless built with HEADLESS=1, both draw the same sorted draw list.
+
+#include "../src/guilay.h"
+#include "../src/common/elements.h"
+
+#include <stdio.h>
+
+#define LABEL_COLUMNS 20
+#define LABEL_ROWS 50
+
+#ifdef GUILAY_HEADLESS
+#define TEST_BACKEND GUILAY_BACKEND_HEADLESS
+#else
+#define TEST_BACKEND GUILAY_BACKEND_SOFTWARE
+#endif
+
+static char labels[LABEL_COLUMNS * LABEL_ROWS][8];
+
+int main() {
+    if (GuilayInitBackend(TEST_BACKEND)) {
+        fprintf(stderr, "FAIL: backend did not start\n");
+        return 1;
+    }
+
+    // The columns stack top to bottom, tall enough that no label is culled
+    Window* window = CreateWindow((Vector2i){120, 16 * LABEL_ROWS * LABEL_COLUMNS}, "label batch test");
+    if (window == NULL || LoadAssets(window)) {
+        fprintf(stderr, "FAIL: window did not open\n");
+        GuilayExit();
+        return 1;
+    }
+    SetWindowRenderMode(window, RENDER_ON_DEMAND);
+
+    for (int column = 0; column < LABEL_COLUMNS; column++) {
+        Section* section = CreateSection((Vector2){120, 16 * LABEL_ROWS}, (Color){0, 0, 0, 0}, NULL);
+        for (int row = 0; row < LABEL_ROWS; row++) {
+            int i = column * LABEL_ROWS + row;
+            snprintf(labels[i], sizeof(labels[i]), "L%d", i);
+            // Every digit of i picks one channel, so no two labels share a color
+            Color color = {(uint8_t)(i % 10 * 25), (uint8_t)(i / 10 % 10 * 25), (uint8_t)(i / 100 * 25), 255};
+            AddSectionChild(section, CreateTextElement(CreateText((Vector2){120, 16}, labels[i], 0.3f, color)));
+        }
+        AddElement(window, CreateSectionElement(section));
+    }
+
+    FillWindow(window, (Color){20, 20, 20, 255});
+    UpdateWindow(window);
+    FrameStats stats = GetFrameStats(window);
+    GuilayExit();
+
+    printf("commands %zu, draw calls %zu, culled %zu\n", stats.drawCommands, stats.drawCalls, stats.culled);
+
+    int failures = 0;
+    if (stats.drawCommands < LABEL_COLUMNS * LABEL_ROWS) {
+        fprintf(stderr, "FAIL: expected a command per glyph of %d labels\n", LABEL_COLUMNS * LABEL_ROWS);
+        failures++;
+    }
+    if (stats.culled != 0) {
+        fprintf(stderr, "FAIL: %zu glyphs were culled\n", stats.culled);
+        failures++;
+    }
+    if (stats.drawCalls != 1) {
+        fprintf(stderr, "FAIL: %zu draw calls, the colors split the batch\n", stats.drawCalls);
+        failures++;
+    }
+
+    if (failures == 0) printf("label batch test passed\n");
+    return failures != 0;
+}
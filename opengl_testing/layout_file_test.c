@@ -0,0 +1,172 @@
+// Loads opengl_testing/sample.glay, which make tests compiles from sample.layout with compile_layout, checks its
+// records and shows it in a window. Then damages copies of it that MapLayout has to turn down.
+// Run from the repository root so the files and the font are found.
+
+#include "../src/guilay.h"
+#include "../src/common/elements.h"
+#include "../src/common/layoutfile.h"
+#include "check.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SAMPLE_PATH "opengl_testing/sample.glay"
+#define DAMAGED_PATH "layout_file_test_damaged.glay"
+
+// The sample in pre-order: a section holding a text, a button, a section with one text and a second button,
+// then a text after the section
+static const ElementType sampleTypes[] = {SECTION, TEXT, BUTTON, SECTION, TEXT, BUTTON, TEXT};
+static const uint32_t sampleEnds[] = {6, 2, 3, 5, 5, 6, 7};
+static const char* sampleStrings[] = {"", "Hello \"layout\"", "Press", "", "Nested", "", "Hello \"layout\""};
+
+static void TestRecords() {
+    LayoutMapping mapping;
+    CHECK(MapLayout(&mapping, SAMPLE_PATH) == 0);
+    if (mapping.data == NULL) return;
+
+    const LayoutHeader* header = GetLayoutHeader(&mapping);
+    const LayoutRecord* records = GetLayoutRecords(&mapping);
+    const char* strings = GetLayoutStrings(&mapping);
+    CHECK(header->elementCount == 7);
+    CHECK(header->rootCount == 2);
+
+    for (uint32_t i = 0; i < header->elementCount && i < 7; i++) {
+        CHECK(records[i].type == sampleTypes[i]);
+        CHECK(records[i].end == sampleEnds[i]);
+        CHECK(strcmp(strings + records[i].text, sampleStrings[i]) == 0);
+        CHECK(records[i].length == strlen(sampleStrings[i]));
+    }
+    // Equal strings are stored once
+    CHECK(records[1].text == records[6].text);
+    CHECK(records[2].scale == 0.4f && records[2].labelColor[2] == 0x00 && records[2].labelColor[1] == 0xff);
+    CHECK(records[3].color[3] == 0xc0);
+
+    UnmapLayout(&mapping);
+}
+
+static void TestWindow() {
+    LayoutFile* layout = OpenLayoutFile(SAMPLE_PATH);
+    CHECK(layout != NULL);
+    if (layout == NULL) return;
+
+    Window* window = CreateWindow((Vector2i){320, 260}, "layout file test");
+    CHECK(window != NULL && LoadAssets(window) == 0);
+    SetWindowRenderMode(window, RENDER_ON_DEMAND);
+    CHECK(AddLayout(window, layout) == 0);
+    FillWindow(window, (Color){0, 0, 0, 255});
+    UpdateWindow(window);
+    CHECK(GetFrameStats(window).drawCommands > 0);
+
+    // The first text of the section, its characters come straight from the mapped file
+    Element* hit = GetElementAt(window, (Vector2){10, 10});
+    CHECK(hit != NULL && hit->type == TEXT);
+    if (hit && hit->type == TEXT) {
+        Text* text = hit->data;
+        CHECK(text->length == 14 && memcmp(text->text, "Hello \"layout\"", 14) == 0);
+    }
+
+    // Windows stop showing the elements before the file goes away
+    ClearWindow(window);
+    CloseLayoutFile(layout);
+    DestroyWindow(window);
+}
+
+static uint8_t* ReadSample(size_t* size) {
+    FILE* file = fopen(SAMPLE_PATH, "rb");
+    if (file == NULL) return NULL;
+    fseek(file, 0, SEEK_END);
+    *size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t* data = malloc(*size);
+    if (data && fread(data, 1, *size, file) != *size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    return data;
+}
+
+// Writes size bytes of data to a file and returns whether MapLayout accepts it
+static bool Accepted(const uint8_t* data, size_t size) {
+    FILE* file = fopen(DAMAGED_PATH, "wb");
+    if (file == NULL) return true;
+    fwrite(data, 1, size, file);
+    fclose(file);
+
+    LayoutMapping mapping;
+    bool accepted = MapLayout(&mapping, DAMAGED_PATH) == 0;
+    if (accepted) UnmapLayout(&mapping);
+    remove(DAMAGED_PATH);
+    return accepted;
+}
+
+// Copies the sample, lets damage change record index and reports whether the result is still accepted
+static bool AcceptedWith(const uint8_t* sample, size_t size, uint32_t index, void (*damage)(LayoutRecord* record)) {
+    uint8_t* copy = malloc(size);
+    if (copy == NULL) return true;
+    memcpy(copy, sample, size);
+
+    LayoutRecord record;
+    size_t offset = sizeof(LayoutHeader) + index * sizeof(LayoutRecord);
+    memcpy(&record, copy + offset, sizeof(LayoutRecord));
+    damage(&record);
+    memcpy(copy + offset, &record, sizeof(LayoutRecord));
+
+    bool accepted = Accepted(copy, size);
+    free(copy);
+    return accepted;
+}
+
+static void EndPastParent(LayoutRecord* record) { record->end = 7; }
+static void EndBeforeSelf(LayoutRecord* record) { record->end = 0; }
+static void LeafWithChildren(LayoutRecord* record) { record->end = 3; }
+static void UnknownType(LayoutRecord* record) { record->type = IMAGE + 1; }
+static void TextPastStrings(LayoutRecord* record) { record->text = 0x1000; }
+static void UnterminatedText(LayoutRecord* record) { record->length++; }
+
+static void TestDamagedFiles() {
+    size_t size = 0;
+    uint8_t* sample = ReadSample(&size);
+    CHECK(sample != NULL);
+    if (sample == NULL) return;
+
+    CHECK(Accepted(sample, size));
+
+    // Cut off in the strings, then in the records
+    CHECK(!Accepted(sample, size - 4));
+    CHECK(!Accepted(sample, sizeof(LayoutHeader) + sizeof(LayoutRecord) / 2));
+    CHECK(!Accepted(sample, sizeof(LayoutHeader) - 1));
+
+    // Records whose nesting or strings CheckSiblings has to turn down, the header is left intact
+    CHECK(!AcceptedWith(sample, size, 3, EndPastParent));
+    CHECK(!AcceptedWith(sample, size, 0, EndBeforeSelf));
+    CHECK(!AcceptedWith(sample, size, 1, LeafWithChildren));
+    CHECK(!AcceptedWith(sample, size, 4, UnknownType));
+    CHECK(!AcceptedWith(sample, size, 2, TextPastStrings));
+    CHECK(!AcceptedWith(sample, size, 1, UnterminatedText));
+
+    // A root count that does not match the records
+    LayoutHeader header;
+    memcpy(&header, sample, sizeof(LayoutHeader));
+    header.rootCount++;
+    memcpy(sample, &header, sizeof(LayoutHeader));
+    CHECK(!Accepted(sample, size));
+
+    free(sample);
+}
+
+int main() {
+    TestRecords();
+    TestDamagedFiles();
+
+    if (GuilayInitBackend(GUILAY_BACKEND_SOFTWARE)) {
+        fprintf(stderr, "FAIL: backend did not start\n");
+        return 1;
+    }
+    TestWindow();
+    GuilayExit();
+
+    if (failures == 0) printf("layout file test passed\n");
+    return failures != 0;
+}
@@ -0,0 +1,90 @@
+// Checks that the spatial index follows the tree: rows taken out of a long child list by hand stop being drawn
+// and hit, rows put back are found again, and scrolling a section moves what is drawn and hit without a layout.
+// Runs in both ElementStorage modes, from the repository root so the font is found.
+
+#include "../src/guilay.h"
+#include "../src/common/elements.h"
+#include "check.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define ROWS 100
+#define KEPT_ROWS 70
+#define ROW_HEIGHT 20
+#define WINDOW_WIDTH 100
+#define WINDOW_HEIGHT (ROWS * ROW_HEIGHT)
+
+static size_t DrawCommands(Window* window) {
+    InvalidateWindow(window);
+    UpdateWindow(window);
+    return GetFrameStats(window).drawCommands;
+}
+
+static Vector2 RowCenter(int row) {
+    return (Vector2){WINDOW_WIDTH / 2.0f, row * ROW_HEIGHT + ROW_HEIGHT / 2.0f};
+}
+
+static void TestStorage(ElementStorage storage) {
+    Window* window = CreateWindow((Vector2i){WINDOW_WIDTH, WINDOW_HEIGHT}, "spatial index test");
+    CHECK(window != NULL && LoadAssets(window) == 0);
+    if (window == NULL) return;
+    SetWindowRenderMode(window, RENDER_ON_DEMAND);
+    SetWindowElementStorage(window, storage);
+    FillWindow(window, (Color){0, 0, 0, 255});
+
+    // Enough rows for the list to be culled with the quadtree, one command each and one for the section
+    BeginWindowArena(window);
+    Section* list = CreateSection((Vector2){WINDOW_WIDTH, WINDOW_HEIGHT}, (Color){40, 40, 40, 255}, NULL);
+    Element* listElement = CreateSectionElement(list);
+    Element* rows[ROWS];
+    for (int i = 0; i < ROWS; i++) {
+        rows[i] = CreateButtonElement(CreateButton((Vector2){WINDOW_WIDTH, ROW_HEIGHT}, (Color){200, 80, 60, 255},
+                                                   NULL, NULL));
+        AddSectionChild(list, rows[i]);
+    }
+    EndWindowArena();
+    AddElement(window, listElement);
+    CHECK(DrawCommands(window) == ROWS + 1);
+    CHECK(GetElementAt(window, RowCenter(80)) == rows[80]);
+
+    // Cut by hand, the rows past the end are left behind in the index until the next sync prunes them
+    LockWindow(window);
+    list->childrenCount = KEPT_ROWS;
+    UnlockWindow(window);
+    CHECK(DrawCommands(window) == KEPT_ROWS + 1);
+    CHECK(GetElementAt(window, RowCenter(80)) == listElement);
+    CHECK(GetElementAt(window, RowCenter(KEPT_ROWS - 1)) == rows[KEPT_ROWS - 1]);
+
+    // The rows come back with new entries
+    LockWindow(window);
+    list->childrenCount = ROWS;
+    UnlockWindow(window);
+    CHECK(DrawCommands(window) == ROWS + 1);
+    CHECK(GetElementAt(window, RowCenter(80)) == rows[80]);
+
+    // Scrolled by ten rows, the first ten go above the section and ten empty rows show at the bottom
+    LockWindow(window);
+    list->scroll.y = 10 * ROW_HEIGHT;
+    UnlockWindowAfter(window, WINDOW_CHANGED_PAINT);
+    CHECK(DrawCommands(window) == ROWS - 10 + 1);
+    CHECK(GetElementAt(window, RowCenter(0)) == rows[10]);
+    CHECK(GetElementAt(window, RowCenter(ROWS - 5)) == listElement);
+    // The layout stays unscrolled
+    CHECK(rows[10]->bounds.position.y == 10 * ROW_HEIGHT);
+
+    DestroyWindow(window);
+}
+
+int main() {
+    if (GuilayInitBackend(GUILAY_BACKEND_SOFTWARE)) {
+        fprintf(stderr, "FAIL: backend did not start\n");
+        return 1;
+    }
+    TestStorage(ELEMENT_STORAGE_TREE);
+    TestStorage(ELEMENT_STORAGE_FLAT);
+    GuilayExit();
+
+    if (failures == 0) printf("spatial index test passed\n");
+    return failures != 0;
+}
@@ -0,0 +1,144 @@
+// Compares the element tree against the flat ElementStore on 100k elements: the layout passes on their own,
+// then whole frames of a window in each ElementStorage mode. Fails when the two disagree on a bound or a pixel.
+// Run from the repository root so the font is found.
+
+#include "../src/guilay.h"
+#include "../src/common/elements.h"
+#include "../src/common/elementstore.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SECTIONS 1000
+#define ROWS_PER_SECTION 99
+#define PASSES 20
+#define WINDOW_WIDTH 800
+#define WINDOW_HEIGHT 600
+
+static double Now() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// A scrolling root of sections holding rows of texts and buttons, 100,001 elements
+static Section* BuildScene() {
+    Section* root = CreateSection((Vector2){WINDOW_WIDTH, WINDOW_HEIGHT}, (Color){30, 30, 30, 255}, NULL);
+    for (int s = 0; s < SECTIONS; s++) {
+        Section* section = CreateSection((Vector2){780, ROWS_PER_SECTION * 24.0f}, (Color){50, (uint8_t)(40 + s % 100), 80, 255}, NULL);
+        for (int i = 0; i < ROWS_PER_SECTION; i++) {
+            if (i % 3 == 0) {
+                AddSectionChild(section, CreateTextElement(CreateText((Vector2){300, 20}, "Row", 0.4f, (Color){255, 255, 255, 255})));
+            } else {
+                AddSectionChild(section, CreateButtonElement(CreateButton((Vector2){200, 20}, (Color){200, 80, 60, 255}, NULL, NULL)));
+            }
+        }
+        AddSectionChild(root, CreateSectionElement(section));
+    }
+    return root;
+}
+
+// Average time of a frame after a change of the given kind, the root is scrolled or recolored on every pass
+static double TimeChanges(Window* window, Section* root, WindowChange change, bool scrolls) {
+    double total = 0;
+    for (int i = 0; i < PASSES; i++) {
+        LockWindow(window);
+        if (scrolls) root->scroll.y = i * 1000.0f;
+        else root->color.green = (uint8_t)(30 + i);
+        UnlockWindowAfter(window, change);
+        double start = Now();
+        UpdateWindow(window);
+        total += Now() - start;
+    }
+    return total / PASSES;
+}
+
+// Draws frames after each kind of change and keeps the last frame
+static void TimeFrames(Window* window, Section* root, ElementStorage storage, uint8_t* pixels) {
+    SetWindowElementStorage(window, storage);
+    FillWindow(window, (Color){0, 0, 0, 255});
+    UpdateWindow(window);
+
+    double tree = TimeChanges(window, root, WINDOW_CHANGED_TREE, false);
+    double layout = TimeChanges(window, root, WINDOW_CHANGED_LAYOUT, false);
+    double paint = TimeChanges(window, root, WINDOW_CHANGED_PAINT, false);
+    double scrolled = TimeChanges(window, root, WINDOW_CHANGED_PAINT, true);
+
+    LockWindow(window);
+    root->scroll.y = 5000;
+    UnlockWindowAfter(window, WINDOW_CHANGED_PAINT);
+    UpdateWindow(window);
+    ReadWindowPixels(window, pixels);
+
+    FrameStats stats = GetFrameStats(window);
+    printf("%s frames: tree changed %.2f ms, sizes %.2f ms, colors %.2f ms, scrolled %.2f ms, "
+           "%zu commands, %zu culled\n", storage == ELEMENT_STORAGE_FLAT ? "flat" : "tree", tree * 1e3,
+           layout * 1e3, paint * 1e3, scrolled * 1e3, stats.drawCommands, stats.culled);
+}
+
+int main() {
+    if (GuilayInitBackend(GUILAY_BACKEND_SOFTWARE)) return 1;
+    Window* window = CreateWindow((Vector2i){WINDOW_WIDTH, WINDOW_HEIGHT}, "storage benchmark");
+    if (window == NULL || LoadAssets(window)) {
+        fprintf(stderr, "FAIL: window did not open\n");
+        GuilayExit();
+        return 1;
+    }
+    SetWindowRenderMode(window, RENDER_ON_DEMAND);
+
+    Section* root = BuildScene();
+    Element* rootElement = CreateSectionElement(root);
+    Rect area = {{0, 0}, {WINDOW_WIDTH, WINDOW_HEIGHT}};
+    int failures = 0;
+
+    // The passes on their own, before the window owns the tree
+    ElementStore store;
+    InitElementStore(&store);
+
+    double start = Now();
+    for (int i = 0; i < PASSES; i++) LayoutElements(&rootElement, 1, area);
+    double treeLayout = (Now() - start) / PASSES;
+
+    start = Now();
+    for (int i = 0; i < PASSES; i++) FlattenElements(&store, &rootElement, 1);
+    double flatten = (Now() - start) / PASSES;
+
+    start = Now();
+    for (int i = 0; i < PASSES; i++) LayoutElementStore(&store, area);
+    double flatLayout = (Now() - start) / PASSES;
+
+    printf("%zu elements: tree layout %.2f ms, flat layout %.2f ms, flattening %.2f ms\n",
+           store.count, treeLayout * 1e3, flatLayout * 1e3, flatten * 1e3);
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < store.count; i++) {
+        if (memcmp(&store.bounds[i], &store.sources[i]->bounds, sizeof(Rect))) mismatches++;
+    }
+    if (mismatches) {
+        fprintf(stderr, "FAIL: %zu bounds differ between the layouts\n", mismatches);
+        failures++;
+    }
+    FreeElementStore(&store);
+
+    // Whole frames, layout, culling, drawing and the spatial index included
+    size_t pixelBytes = (size_t)WINDOW_WIDTH * WINDOW_HEIGHT * 4;
+    uint8_t* treePixels = malloc(pixelBytes);
+    uint8_t* flatPixels = malloc(pixelBytes);
+    if (treePixels == NULL || flatPixels == NULL) return 1;
+
+    AddElement(window, rootElement);
+    TimeFrames(window, root, ELEMENT_STORAGE_TREE, treePixels);
+    TimeFrames(window, root, ELEMENT_STORAGE_FLAT, flatPixels);
+
+    if (memcmp(treePixels, flatPixels, pixelBytes)) {
+        fprintf(stderr, "FAIL: the tree and flat frames differ\n");
+        failures++;
+    }
+
+    free(treePixels);
+    free(flatPixels);
+    GuilayExit();
+    return failures != 0;
+}
@@ -0,0 +1,128 @@
+// Checks string interning: equal strings share one entry, entries and their characters never move while the
+// table grows, and interned texts are measured once. Run from the repository root so the font is found.
+
+#include "../src/guilay.h"
+#include "../src/common/elements.h"
+#include "../src/common/stringtable.h"
+#include "check.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define GROWTH_STRINGS (STRING_TABLE_BLOCK * 40)
+
+// The table guilay interns into, read here to see what MeasureText cached
+extern StringTable strings;
+
+static void TestInterning() {
+    StringTable table;
+    InitStringTable(&table);
+
+    // Equal characters from different buffers, and views that stop early
+    char buffer[] = "Settings";
+    uint32_t settings = StringTableIntern(&table, ViewString("Settings"));
+    CHECK(settings != 0);
+    CHECK(StringTableIntern(&table, ViewString(buffer)) == settings);
+    CHECK(StringTableIntern(&table, (StringView){"Settings and more", 8}) == settings);
+    CHECK(StringTableGet(&table, settings)->string.data != buffer);
+
+    uint32_t set = StringTableIntern(&table, (StringView){"Settings", 3});
+    CHECK(set != 0 && set != settings);
+    CHECK(strcmp(StringTableGet(&table, set)->string.data, "Set") == 0);
+
+    uint32_t empty = StringTableIntern(&table, (StringView){"", 0});
+    CHECK(empty != 0 && StringTableIntern(&table, (StringView){NULL, 0}) == empty);
+    CHECK(StringTableGet(&table, empty)->string.length == 0);
+
+    CHECK(StringTableGet(&table, 0) == NULL);
+    CHECK(StringTableGet(&table, table.count + 1) == NULL);
+    CHECK(table.count == 3);
+
+    FreeStringTable(&table);
+}
+
+static void TestGrowth() {
+    StringTable table;
+    InitStringTable(&table);
+
+    uint32_t first = StringTableIntern(&table, ViewString("first"));
+    InternedString* entry = StringTableGet(&table, first);
+    const char* characters = entry->string.data;
+    entry->width = 42;
+
+    // Many entry blocks, bucket rehashes and arena blocks later
+    char label[32];
+    uint32_t ids[GROWTH_STRINGS];
+    for (int i = 0; i < GROWTH_STRINGS; i++) {
+        snprintf(label, sizeof(label), "label %d", i);
+        ids[i] = StringTableIntern(&table, ViewString(label));
+        CHECK(ids[i] == (uint32_t)i + 2);
+    }
+
+    CHECK(StringTableGet(&table, first) == entry);
+    CHECK(entry->string.data == characters);
+    CHECK(strcmp(characters, "first") == 0);
+    CHECK(entry->width == 42);
+    CHECK(StringTableIntern(&table, ViewString("first")) == first);
+
+    // Every string is still found again and reads back the same
+    for (int i = 0; i < GROWTH_STRINGS; i++) {
+        snprintf(label, sizeof(label), "label %d", i);
+        if (StringTableIntern(&table, ViewString(label)) != ids[i] ||
+            strcmp(StringTableGet(&table, ids[i])->string.data, label) != 0) {
+            fprintf(stderr, "FAIL: %s moved or was lost\n", label);
+            failures++;
+            break;
+        }
+    }
+    CHECK(table.count == GROWTH_STRINGS + 1);
+
+    FreeStringTable(&table);
+}
+
+static void TestMeasuredOnce() {
+    Window* window = CreateWindow((Vector2i){64, 64}, "string table test");
+    CHECK(window != NULL && LoadAssets(window) == 0);
+    if (window == NULL) return;
+
+    // The texts live in the window's arena and go with it
+    BeginWindowArena(window);
+    StringId id = InternString(ViewString("Measured once"));
+    CHECK(InternString(ViewString("Measured once")) == id);
+    Text* small = CreateInternedText((Vector2){64, 16}, id, 0.5f, (Color){255, 255, 255, 255});
+    Text* large = CreateInternedText((Vector2){64, 16}, id, 1.0f, (Color){255, 255, 255, 255});
+
+    InternedString* entry = StringTableGet(&strings, id);
+    CHECK(entry->width < 0);
+    float width = MeasureText(large);
+    CHECK(width > 0);
+    CHECK(entry->width == width);
+    CHECK(MeasureText(small) == width * 0.5f);
+
+    // A width the font would never give proves the cached one is used instead of measuring again
+    entry->width = 1000;
+    CHECK(MeasureText(large) == 1000);
+    CHECK(MeasureText(small) == 500);
+
+    // Texts viewing the same characters without the id are measured every time
+    Text* plain = CreateText((Vector2){64, 16}, "Measured once", 1.0f, (Color){255, 255, 255, 255});
+    CHECK(MeasureText(plain) == width);
+
+    EndWindowArena();
+    DestroyWindow(window);
+}
+
+int main() {
+    TestInterning();
+    TestGrowth();
+
+    if (GuilayInitBackend(GUILAY_BACKEND_SOFTWARE)) {
+        fprintf(stderr, "FAIL: backend did not start\n");
+        return 1;
+    }
+    TestMeasuredOnce();
+    GuilayExit();
+
+    if (failures == 0) printf("string table test passed\n");
+    return failures != 0;
+}
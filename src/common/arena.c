@@ -0,0 +1,88 @@
+#include "arena.h"
+
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGNMENT alignof(max_align_t)
+// Block headers are padded so the first allocation is aligned as well
+#define ARENA_HEADER_SIZE ((sizeof(ArenaBlock) + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1))
+
+void ArenaInit(Arena* arena) {
+    memset(arena, 0, sizeof(Arena));
+}
+
+void ArenaDestroy(Arena* arena) {
+    ArenaBlock* block = arena->blocks;
+    while (block) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    ArenaInit(arena);
+}
+
+void ArenaReset(Arena* arena) {
+    if (arena->blocks == NULL) return;
+
+    // Usually the newest block, unless an oversized allocation got a block of its own before it
+    ArenaBlock* biggest = arena->blocks;
+    for (ArenaBlock* block = biggest->next; block; block = block->next) {
+        if (block->size > biggest->size) biggest = block;
+    }
+
+    ArenaBlock* block = arena->blocks;
+    while (block) {
+        ArenaBlock* next = block->next;
+        if (block != biggest) free(block);
+        block = next;
+    }
+
+    arena->blocks = biggest;
+    biggest->next = NULL;
+    biggest->used = 0;
+    arena->allocated = 0;
+    arena->reserved = biggest->size;
+}
+
+static ArenaBlock* AddBlock(Arena* arena, size_t needed) {
+    size_t size = arena->blocks ? arena->blocks->size * 2 : ARENA_FIRST_BLOCK;
+    if (size > ARENA_MAX_BLOCK) size = ARENA_MAX_BLOCK;
+    if (size < needed) size = needed;
+
+    ArenaBlock* block = malloc(ARENA_HEADER_SIZE + size);
+    if (block == NULL) {
+        fprintf(stderr, "ERROR::ARENA::BLOCK_ALLOCATION_FAILED\n");
+        return NULL;
+    }
+
+    block->next = arena->blocks;
+    block->size = size;
+    block->used = 0;
+    arena->blocks = block;
+    arena->reserved += size;
+    return block;
+}
+
+void* ArenaAlloc(Arena* arena, size_t size) {
+    size = (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+
+    ArenaBlock* block = arena->blocks;
+    // The rest of a block too small for this allocation is given up
+    if (block == NULL || block->size - block->used < size) block = AddBlock(arena, size);
+    if (block == NULL) return NULL;
+
+    void* memory = (char*)block + ARENA_HEADER_SIZE + block->used;
+    block->used += size;
+    arena->allocated += size;
+    return memory;
+}
+
+char* ArenaCopyString(Arena* arena, const char* string) {
+    size_t length = strlen(string) + 1;
+    char* copy = ArenaAlloc(arena, length);
+    if (copy) memcpy(copy, string, length);
+    return copy;
+}
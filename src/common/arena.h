@@ -0,0 +1,34 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// First block size, every new block doubles up to ARENA_MAX_BLOCK so big trees need few blocks
+#define ARENA_FIRST_BLOCK (64 * 1024)
+#define ARENA_MAX_BLOCK (4 * 1024 * 1024)
+
+typedef struct ArenaBlock {
+    struct ArenaBlock* next; // Older blocks
+    size_t size;
+    size_t used;
+} ArenaBlock;
+
+// Bump allocator, allocations are never freed one by one, only all at once with ArenaReset or ArenaDestroy
+typedef struct Arena {
+    ArenaBlock* blocks; // Newest first, only the newest one is allocated from
+    size_t allocated;   // Bytes handed out since the last reset
+    size_t reserved;    // Bytes of every block together
+} Arena;
+
+void ArenaInit(Arena* arena);
+// Frees every block
+void ArenaDestroy(Arena* arena);
+// Forgets every allocation but keeps the biggest block for the next round
+void ArenaReset(Arena* arena);
+
+// Aligned for any type, returns NULL when no block could be added
+void* ArenaAlloc(Arena* arena, size_t size);
+// Copies a string into the arena
+char* ArenaCopyString(Arena* arena, const char* string);
+
+#endif
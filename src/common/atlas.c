@@ -0,0 +1,179 @@
+#include "atlas.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double Seconds() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// ----------- Free rectangles -----------
+
+static int PushFree(AtlasPacker* packer, AtlasRect rect) {
+    if (packer->freeCount == packer->freeCapacity) {
+        size_t capacity = packer->freeCapacity ? packer->freeCapacity * 2 : 64;
+        AtlasRect* grown = realloc(packer->free, capacity * sizeof(AtlasRect));
+        if (grown == NULL) {
+            fprintf(stderr, "ERROR::ATLAS::FREE_LIST_ALLOCATION_FAILED\n");
+            return 1;
+        }
+        packer->free = grown;
+        packer->freeCapacity = capacity;
+    }
+
+    packer->free[packer->freeCount++] = rect;
+    return 0;
+}
+
+static void RemoveFree(AtlasPacker* packer, size_t index) {
+    packer->free[index] = packer->free[--packer->freeCount];
+}
+
+static int RectContains(AtlasRect outer, AtlasRect inner) {
+    return inner.x >= outer.x && inner.y >= outer.y &&
+           inner.x + inner.width <= outer.x + outer.width && inner.y + inner.height <= outer.y + outer.height;
+}
+
+static int RectsOverlap(AtlasRect a, AtlasRect b) {
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+// Adds rect unless a free rectangle already covers it, dropping the ones it covers.
+// Keeps the list free of nested rectangles, which add nothing but search time.
+static void AddFree(AtlasPacker* packer, AtlasRect rect) {
+    for (size_t i = 0; i < packer->freeCount; i++) {
+        if (RectContains(packer->free[i], rect)) return;
+    }
+    for (size_t i = packer->freeCount; i-- > 0;) {
+        if (RectContains(rect, packer->free[i])) RemoveFree(packer, i);
+    }
+    PushFree(packer, rect);
+}
+
+// Adds the up to four maximal rectangles of free that are left around used
+static void SplitFree(AtlasPacker* packer, AtlasRect free, AtlasRect used) {
+    if (used.x > free.x) {
+        AddFree(packer, (AtlasRect){free.x, free.y, used.x - free.x, free.height});
+    }
+    if (used.x + used.width < free.x + free.width) {
+        int right = used.x + used.width;
+        AddFree(packer, (AtlasRect){right, free.y, free.x + free.width - right, free.height});
+    }
+    if (used.y > free.y) {
+        AddFree(packer, (AtlasRect){free.x, free.y, free.width, used.y - free.y});
+    }
+    if (used.y + used.height < free.y + free.height) {
+        int bottom = used.y + used.height;
+        AddFree(packer, (AtlasRect){free.x, bottom, free.width, free.y + free.height - bottom});
+    }
+}
+
+// Joins b into a when they share a whole edge
+static int MergeRects(AtlasRect* a, AtlasRect b) {
+    if (a->x == b.x && a->width == b.width && (a->y + a->height == b.y || b.y + b.height == a->y)) {
+        if (b.y < a->y) a->y = b.y;
+        a->height += b.height;
+        return 1;
+    }
+    if (a->y == b.y && a->height == b.height && (a->x + a->width == b.x || b.x + b.width == a->x)) {
+        if (b.x < a->x) a->x = b.x;
+        a->width += b.width;
+        return 1;
+    }
+    return 0;
+}
+
+// ----------- Packer -----------
+
+int AtlasPackerInit(AtlasPacker* packer, int width, int height, int padding) {
+    memset(packer, 0, sizeof(AtlasPacker));
+    packer->width = width;
+    packer->height = height;
+    packer->padding = padding;
+    return PushFree(packer, (AtlasRect){0, 0, width, height});
+}
+
+void AtlasPackerDestroy(AtlasPacker* packer) {
+    free(packer->free);
+    memset(packer, 0, sizeof(AtlasPacker));
+}
+
+int AtlasAllocate(AtlasPacker* packer, int width, int height, AtlasRect* rect) {
+    double start = Seconds();
+    int paddedWidth = width + packer->padding, paddedHeight = height + packer->padding;
+
+    // Best short side fit, the free rectangle leaving the smallest sliver next to the new one
+    size_t best = packer->freeCount;
+    int bestShort = 0, bestLong = 0;
+    for (size_t i = 0; i < packer->freeCount; i++) {
+        AtlasRect free = packer->free[i];
+        if (free.width < paddedWidth || free.height < paddedHeight) continue;
+
+        int leftoverX = free.width - paddedWidth, leftoverY = free.height - paddedHeight;
+        int shortSide = leftoverX < leftoverY ? leftoverX : leftoverY;
+        int longSide = leftoverX < leftoverY ? leftoverY : leftoverX;
+        if (best == packer->freeCount || shortSide < bestShort || (shortSide == bestShort && longSide < bestLong)) {
+            best = i;
+            bestShort = shortSide;
+            bestLong = longSide;
+        }
+    }
+    packer->stats.rectsVisited += packer->freeCount;
+
+    if (width <= 0 || height <= 0 || best == packer->freeCount) {
+        packer->stats.failures++;
+        packer->stats.allocateSeconds += Seconds() - start;
+        return 1;
+    }
+
+    AtlasRect used = {packer->free[best].x, packer->free[best].y, paddedWidth, paddedHeight};
+    // Walks down so the rectangles split off, which never overlap used, are not visited again.
+    // They are only ever added past i and can never contain a rectangle below it.
+    for (size_t i = packer->freeCount; i-- > 0;) {
+        AtlasRect free = packer->free[i];
+        if (!RectsOverlap(free, used)) continue;
+
+        RemoveFree(packer, i);
+        SplitFree(packer, free, used);
+    }
+
+    packer->stats.allocations++;
+    packer->stats.usedArea += (size_t)paddedWidth * paddedHeight;
+    packer->stats.allocateSeconds += Seconds() - start;
+
+    *rect = (AtlasRect){used.x, used.y, width, height};
+    return 0;
+}
+
+void AtlasFree(AtlasPacker* packer, AtlasRect rect) {
+    AtlasRect used = {rect.x, rect.y, rect.width + packer->padding, rect.height + packer->padding};
+    packer->stats.allocations--;
+    packer->stats.usedArea -= (size_t)used.width * used.height;
+
+    // An empty atlas is one free rectangle again, however fragmented it got
+    if (packer->stats.allocations == 0) {
+        packer->freeCount = 0;
+        PushFree(packer, (AtlasRect){0, 0, packer->width, packer->height});
+        return;
+    }
+
+    // Grows the freed rectangle over the free ones lining up with it, those end up inside of it
+    for (size_t i = 0; i < packer->freeCount;) {
+        if (MergeRects(&used, packer->free[i])) {
+            RemoveFree(packer, i);
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+    AddFree(packer, used);
+}
+
+float AtlasOccupancy(const AtlasPacker* packer) {
+    size_t area = (size_t)packer->width * packer->height;
+    return area ? (float)packer->stats.usedArea / area : 0;
+}
@@ -0,0 +1,45 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include <stddef.h>
+
+// A rectangle of texels in an atlas texture
+typedef struct AtlasRect {
+    int x, y;
+    int width, height;
+} AtlasRect;
+
+typedef struct AtlasPackerStats {
+    size_t allocations;    // Rectangles currently handed out
+    size_t failures;       // Requests that did not fit
+    size_t usedArea;       // Texels handed out, padding included
+    size_t rectsVisited;   // Free rectangles examined by all allocations, the cost of packing
+    double allocateSeconds; // Time spent in AtlasAllocate
+} AtlasPackerStats;
+
+// Hands out space of a width * height texture with MaxRects, best short side fit.
+// Free space is a list of possibly overlapping maximal rectangles, placing a rectangle splits
+// every free one it touches and freeing one merges it back with the free rectangles it lines up with.
+typedef struct AtlasPacker {
+    int width;
+    int height;
+    int padding; // Empty texels kept right of and below every rectangle, so filtering never samples a neighbour
+
+    AtlasRect* free;
+    size_t freeCount;
+    size_t freeCapacity;
+
+    AtlasPackerStats stats;
+} AtlasPacker;
+
+int AtlasPackerInit(AtlasPacker* packer, int width, int height, int padding);
+void AtlasPackerDestroy(AtlasPacker* packer);
+
+// Finds room for width * height texels and writes where to rect, returns 1 when it does not fit
+int AtlasAllocate(AtlasPacker* packer, int width, int height, AtlasRect* rect);
+// Gives back a rectangle AtlasAllocate handed out
+void AtlasFree(AtlasPacker* packer, AtlasRect rect);
+// Share of the atlas area that is handed out, from 0 to 1
+float AtlasOccupancy(const AtlasPacker* packer);
+
+#endif
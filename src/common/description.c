@@ -0,0 +1,80 @@
+#include "description.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void InitDescription(Description* description) {
+    memset(description, 0, sizeof(Description));
+}
+
+void FreeDescription(Description* description) {
+    free(description->elements);
+    free(description->characters);
+    free(description->open);
+    InitDescription(description);
+}
+
+void ResetDescription(Description* description) {
+    description->count = 0;
+    description->characterCount = 0;
+    description->depth = 0;
+    description->failed = false;
+}
+
+// Doubles *capacity until needed items of itemSize fit
+static int Reserve(void** array, size_t* capacity, size_t needed, size_t itemSize) {
+    if (needed <= *capacity) return 0;
+
+    size_t grown = *capacity ? *capacity : 64;
+    while (grown < needed) grown *= 2;
+    void* items = realloc(*array, grown * itemSize);
+    if (items == NULL) return 1;
+    *array = items;
+    *capacity = grown;
+    return 0;
+}
+
+DescribedElement* DescribeElement(Description* description, ElementType type, uint64_t key, StringView text) {
+    if (description->count >= UINT32_MAX - 1 ||
+        Reserve((void**)&description->elements, &description->capacity, description->count + 1, sizeof(DescribedElement)) ||
+        Reserve((void**)&description->characters, &description->characterCapacity,
+                description->characterCount + text.length + 1, 1)) {
+        fprintf(stderr, "Error: Description allocation failed.\n");
+        description->failed = true;
+        return NULL;
+    }
+
+    // Strings often come from buffers that are reused for the next element, so they are copied right away
+    size_t offset = description->characterCount;
+    if (text.length) memcpy(description->characters + offset, text.data, text.length);
+    description->characters[offset + text.length] = '\0';
+    description->characterCount += text.length + 1;
+
+    DescribedElement* element = &description->elements[description->count];
+    memset(element, 0, sizeof(DescribedElement));
+    element->type = type;
+    element->key = key;
+    element->text = offset;
+    element->length = text.length;
+    element->end = (uint32_t)++description->count;
+    return element;
+}
+
+void OpenDescribedSection(Description* description) {
+    if (description->count == 0 || description->elements[description->count - 1].type != SECTION) return;
+    if (Reserve((void**)&description->open, &description->openCapacity, description->depth + 1, sizeof(uint32_t))) {
+        description->failed = true;
+        return;
+    }
+    description->open[description->depth++] = (uint32_t)(description->count - 1);
+}
+
+void CloseDescribedSection(Description* description) {
+    if (description->depth == 0) return;
+    description->elements[description->open[--description->depth]].end = (uint32_t)description->count;
+}
+
+StringView GetDescribedText(const Description* description, const DescribedElement* element) {
+    return (StringView){description->characters + element->text, element->length};
+}
@@ -0,0 +1,54 @@
+#ifndef DESCRIPTION_H
+#define DESCRIPTION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "elements.h"
+#include "types.h"
+
+// One element of a description, what it should look like rather than the element itself
+typedef struct DescribedElement {
+    ElementType type;
+    uint64_t key;       // Tells the element apart from its siblings across descriptions
+    Vector2 size;
+    Vector2 scroll;     // Sections
+    Color color;        // Section and button fills, image tints, text colors
+    Color labelColor;   // Buttons
+    float scale;        // Texts and button labels
+    size_t text;        // Offset of the text, button label or image path in the characters of the description
+    size_t length;
+    void (*onClick)(void);
+    uint32_t end;       // One past the last element inside of it
+} DescribedElement;
+
+// A whole element tree in pre-order with copies of its strings, filled again every time the application
+// describes its UI. The arrays are kept between descriptions, so describing a screen of the same shape
+// again allocates nothing.
+typedef struct Description {
+    DescribedElement* elements;
+    size_t count;
+    size_t capacity;
+    char* characters;
+    size_t characterCount;
+    size_t characterCapacity;
+    uint32_t* open; // Sections whose elements are still being described
+    size_t depth;
+    size_t openCapacity;
+    bool failed;    // Memory ran out somewhere, the description is incomplete
+} Description;
+
+void InitDescription(Description* description);
+void FreeDescription(Description* description);
+// Forgets every element but keeps the memory
+void ResetDescription(Description* description);
+
+// Appends an element inside of the innermost open section and copies text, returns NULL when memory ran out
+DescribedElement* DescribeElement(Description* description, ElementType type, uint64_t key, StringView text);
+// Makes the last described element, a section, take the elements described until CloseDescribedSection
+void OpenDescribedSection(Description* description);
+void CloseDescribedSection(Description* description);
+StringView GetDescribedText(const Description* description, const DescribedElement* element);
+
+#endif
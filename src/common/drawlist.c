@@ -0,0 +1,386 @@
+#include "drawlist.h"
+
+#include <float.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// How many batches back a command may look for one with matching state.
+// Keeps the sort linear on frames with lots of distinct state.
+#define DRAW_SORT_LOOKBACK 64
+// How many commands of a batch are tested one by one once its union bounds overlap,
+// bigger batches are treated as overlapping to stay cheap
+#define DRAW_SORT_EXACT_CHECKS 16
+
+typedef struct {
+    DrawLayer layer;
+    size_t index;
+} LayerKey;
+
+typedef struct {
+    size_t head;
+    size_t tail;
+    unsigned int texture; // The texture sampled by the batch, 0 until a command needs one
+    Rect bounds; // Union of the bounds of every command in the batch
+} DrawBatch;
+
+// ----------- Helpers -----------
+
+static int GrowArray(void** array, size_t* capacity, size_t needed, size_t elementSize) {
+    if (needed <= *capacity) return 0;
+
+    size_t newCapacity = *capacity ? *capacity : 64;
+    while (newCapacity < needed) newCapacity *= 2;
+
+    void* temp = realloc(*array, newCapacity * elementSize);
+    if (temp == NULL) {
+        fprintf(stderr, "Error: Draw list allocation failed.\n");
+        return 1;
+    }
+
+    *array = temp;
+    *capacity = newCapacity;
+    return 0;
+}
+
+static int RectsOverlap(Rect a, Rect b) {
+    return a.position.x < b.position.x + b.size.x && b.position.x < a.position.x + a.size.x &&
+           a.position.y < b.position.y + b.size.y && b.position.y < a.position.y + a.size.y;
+}
+
+static Rect RectUnion(Rect a, Rect b) {
+    float left   = a.position.x < b.position.x ? a.position.x : b.position.x;
+    float top    = a.position.y < b.position.y ? a.position.y : b.position.y;
+    float right  = a.position.x + a.size.x > b.position.x + b.size.x ? a.position.x + a.size.x : b.position.x + b.size.x;
+    float bottom = a.position.y + a.size.y > b.position.y + b.size.y ? a.position.y + a.size.y : b.position.y + b.size.y;
+    return (Rect){{left, top}, {right - left, bottom - top}};
+}
+
+static int TexturesMatch(unsigned int a, unsigned int b) {
+    return a == 0 || b == 0 || a == b;
+}
+
+// Orders batches by (program, texture, blend), layers are handled before this is used
+static int BatchLess(const DrawCommand* commands, const DrawBatch* a, const DrawBatch* b) {
+    const DrawCommand* first = &commands[a->head];
+    const DrawCommand* second = &commands[b->head];
+    if (first->program != second->program) return first->program < second->program;
+    if (a->texture != b->texture) return a->texture < b->texture;
+    return first->blend < second->blend;
+}
+
+static int CompareLayerKeys(const void* a, const void* b) {
+    const LayerKey* ka = a;
+    const LayerKey* kb = b;
+    if (ka->layer != kb->layer) return ka->layer < kb->layer ? -1 : 1;
+    // Ties fall back to submission order which makes qsort stable
+    return ka->index < kb->index ? -1 : (ka->index > kb->index);
+}
+
+static int BatchOverlapsRect(const DrawCommand* commands, const size_t* next, size_t end, const DrawBatch* batch, Rect rect) {
+    if (!RectsOverlap(batch->bounds, rect)) return 0;
+
+    size_t checked = 0;
+    for (size_t index = batch->head; index != end; index = next[index]) {
+        if (++checked > DRAW_SORT_EXACT_CHECKS || RectsOverlap(commands[index].bounds, rect)) return 1;
+    }
+    return 0;
+}
+
+static int BatchesOverlap(const DrawCommand* commands, const size_t* next, size_t end, const DrawBatch* a, const DrawBatch* b) {
+    if (!RectsOverlap(a->bounds, b->bounds)) return 0;
+
+    size_t checked = 0;
+    for (size_t index = a->head; index != end; index = next[index]) {
+        if (++checked > DRAW_SORT_EXACT_CHECKS || BatchOverlapsRect(commands, next, end, b, commands[index].bounds)) return 1;
+    }
+    return 0;
+}
+
+// Commands without a texture keep whatever is bound, so texture switches are counted against boundTexture
+static size_t StateChanges(const DrawCommand* prev, const DrawCommand* next, unsigned int* boundTexture) {
+    size_t textureChange = !TexturesMatch(*boundTexture, next->texture);
+    if (next->texture) *boundTexture = next->texture;
+    if (prev == NULL) return 3;
+
+    return (prev->program != next->program) +
+           textureChange +
+           (prev->blend != next->blend);
+}
+
+// ----------- Draw list -----------
+
+void InitDrawList(DrawList* list) {
+    memset(list, 0, sizeof(DrawList));
+}
+
+void ClearDrawList(DrawList* list) {
+    list->vertexCount = 0;
+    list->commandCount = 0;
+    list->callCount = 0;
+    list->clipCount = 0;
+    memset(&list->stats, 0, sizeof(DrawListStats));
+}
+
+void FreeDrawList(DrawList* list) {
+    free(list->vertices);
+    free(list->commands);
+    free(list->order);
+    free(list->sortedVertices);
+    free(list->calls);
+    free(list->clips);
+    InitDrawList(list);
+}
+
+int PushDrawCommand(DrawList* list, const DrawCommand* state, const DrawVertex* vertices, size_t vertexCount) {
+    if (GrowArray((void**)&list->vertices, &list->vertexCapacity, list->vertexCount + vertexCount, sizeof(DrawVertex)))
+        return 1;
+    if (GrowArray((void**)&list->commands, &list->commandCapacity, list->commandCount + 1, sizeof(DrawCommand)))
+        return 1;
+
+    DrawCommand* command = &list->commands[list->commandCount++];
+    *command = *state;
+    command->firstVertex = list->vertexCount;
+    command->vertexCount = vertexCount;
+
+    memcpy(list->vertices + list->vertexCount, vertices, vertexCount * sizeof(DrawVertex));
+    list->vertexCount += vertexCount;
+    return 0;
+}
+
+// ----------- Clipping -----------
+
+void PushDrawClip(DrawList* list, Rect rect) {
+    if (GrowArray((void**)&list->clips, &list->clipCapacity, list->clipCount + 1, sizeof(Rect))) return;
+
+    if (list->clipCount) {
+        Rect top = list->clips[list->clipCount - 1];
+        float left   = rect.position.x > top.position.x ? rect.position.x : top.position.x;
+        float upper  = rect.position.y > top.position.y ? rect.position.y : top.position.y;
+        float right  = rect.position.x + rect.size.x < top.position.x + top.size.x ? rect.position.x + rect.size.x : top.position.x + top.size.x;
+        float bottom = rect.position.y + rect.size.y < top.position.y + top.size.y ? rect.position.y + rect.size.y : top.position.y + top.size.y;
+        rect = (Rect){{left, upper}, {right > left ? right - left : 0, bottom > upper ? bottom - upper : 0}};
+    }
+    list->clips[list->clipCount++] = rect;
+}
+
+void PopDrawClip(DrawList* list) {
+    if (list->clipCount) list->clipCount--;
+}
+
+int DrawClipVisible(const DrawList* list, Rect rect) {
+    if (list->clipCount == 0) return 1;
+    return RectsOverlap(list->clips[list->clipCount - 1], rect);
+}
+
+Rect GetDrawClip(const DrawList* list) {
+    if (list->clipCount) return list->clips[list->clipCount - 1];
+    return (Rect){{-FLT_MAX / 4, -FLT_MAX / 4}, {FLT_MAX / 2, FLT_MAX / 2}};
+}
+
+// ----------- Primitives -----------
+
+static int PushQuad(DrawList* list, const DrawCommand* state, DrawKind kind, Rect rect, Rect uv, const float* shape) {
+    float left = rect.position.x, top = rect.position.y;
+    float right = left + rect.size.x, bottom = top + rect.size.y;
+    float u0 = uv.position.x, v0 = uv.position.y;
+    float u1 = u0 + uv.size.x, v1 = v0 + uv.size.y;
+
+    if (list->clipCount) {
+        Rect clip = list->clips[list->clipCount - 1];
+        if (!RectsOverlap(clip, rect)) {
+            list->stats.culled++;
+            return 0;
+        }
+
+        // Texture coordinates are linear over the quad, so cutting an edge moves them by the same fraction
+        float clipRight = clip.position.x + clip.size.x, clipBottom = clip.position.y + clip.size.y;
+        float du = (u1 - u0) / rect.size.x, dv = (v1 - v0) / rect.size.y;
+        if (left < clip.position.x) { u0 += (clip.position.x - left) * du; left = clip.position.x; }
+        if (right > clipRight)      { u1 -= (right - clipRight) * du;      right = clipRight; }
+        if (top < clip.position.y)  { v0 += (clip.position.y - top) * dv;  top = clip.position.y; }
+        if (bottom > clipBottom)    { v1 -= (bottom - clipBottom) * dv;    bottom = clipBottom; }
+    }
+
+    float s0 = shape ? shape[0] : 0, s1 = shape ? shape[1] : 0, s2 = shape ? shape[2] : 0;
+    Color c = state->color;
+    DrawVertex vertices[6] = {
+        { left,  top,    u0, v0, (float)kind, {s0, s1, s2}, {c.red, c.green, c.blue, c.alpha} },
+        { left,  bottom, u0, v1, (float)kind, {s0, s1, s2}, {c.red, c.green, c.blue, c.alpha} },
+        { right, bottom, u1, v1, (float)kind, {s0, s1, s2}, {c.red, c.green, c.blue, c.alpha} },
+
+        { left,  top,    u0, v0, (float)kind, {s0, s1, s2}, {c.red, c.green, c.blue, c.alpha} },
+        { right, bottom, u1, v1, (float)kind, {s0, s1, s2}, {c.red, c.green, c.blue, c.alpha} },
+        { right, top,    u1, v0, (float)kind, {s0, s1, s2}, {c.red, c.green, c.blue, c.alpha} }
+    };
+
+    DrawCommand command = *state;
+    command.bounds = (Rect){{left, top}, {right - left, bottom - top}};
+    return PushDrawCommand(list, &command, vertices, 6);
+}
+
+int PushDrawQuad(DrawList* list, const DrawCommand* state, DrawKind kind, Rect rect, Rect uv) {
+    return PushQuad(list, state, kind, rect, uv, NULL);
+}
+
+int PushDrawRoundedRect(DrawList* list, const DrawCommand* state, Rect rect, float radius) {
+    float halfWidth = rect.size.x * 0.5f, halfHeight = rect.size.y * 0.5f;
+    float limit = halfWidth < halfHeight ? halfWidth : halfHeight;
+    if (radius > limit) radius = limit;
+    if (radius < 0) radius = 0;
+
+    DrawCommand command = *state;
+    command.texture = 0;
+
+    // The texture coordinates carry the offset from the center the fragment stage measures the corners with
+    float shape[3] = {halfWidth, halfHeight, radius};
+    return PushQuad(list, &command, DRAW_KIND_ROUNDED_RECT, rect, (Rect){{-halfWidth, -halfHeight}, rect.size}, shape);
+}
+
+int DrawCommandsMatch(const DrawCommand* a, const DrawCommand* b) {
+    return a->layer == b->layer &&
+           a->program == b->program &&
+           TexturesMatch(a->texture, b->texture) &&
+           a->blend == b->blend;
+}
+
+// ----------- Sorting -----------
+
+// Copies the vertices into draw order and merges neighbouring commands that share state
+static void BuildDrawCalls(DrawList* list) {
+    list->callCount = 0;
+
+    if (GrowArray((void**)&list->sortedVertices, &list->sortedCapacity, list->vertexCount, sizeof(DrawVertex)) ||
+        GrowArray((void**)&list->calls, &list->callCapacity, list->commandCount, sizeof(DrawCall)))
+        return;
+
+    size_t written = 0;
+    for (size_t i = 0; i < list->commandCount; i++) {
+        const DrawCommand* command = &list->commands[list->order[i]];
+
+        memcpy(list->sortedVertices + written, list->vertices + command->firstVertex,
+               command->vertexCount * sizeof(DrawVertex));
+
+        DrawCall* last = list->callCount ? &list->calls[list->callCount - 1] : NULL;
+        if (last && DrawCommandsMatch(&list->commands[last->command], command) &&
+            TexturesMatch(last->texture, command->texture)) {
+            last->vertexCount += command->vertexCount;
+            if (!last->texture) last->texture = command->texture;
+        } else {
+            list->calls[list->callCount++] = (DrawCall){list->order[i], command->texture, written, command->vertexCount};
+        }
+        written += command->vertexCount;
+    }
+}
+
+static size_t CountStateChanges(const DrawCommand* commands, const size_t* order, size_t count) {
+    size_t changes = 0;
+    unsigned int boundTexture = 0;
+    const DrawCommand* prev = NULL;
+    for (size_t i = 0; i < count; i++) {
+        const DrawCommand* next = &commands[order ? order[i] : i];
+        changes += StateChanges(prev, next, &boundTexture);
+        prev = next;
+    }
+    return changes;
+}
+
+void SortDrawList(DrawList* list) {
+    size_t count = list->commandCount;
+    DrawCommand* commands = list->commands;
+
+    if (GrowArray((void**)&list->order, &list->orderCapacity, count, sizeof(size_t))) return;
+
+    list->stats.commandCount = count;
+    list->stats.stateChangesBefore = CountStateChanges(commands, NULL, count);
+
+    LayerKey* keys = malloc(count * sizeof(LayerKey));
+    DrawBatch* batches = malloc(count * sizeof(DrawBatch));
+    size_t* next = malloc(count * sizeof(size_t));
+
+    if (count && (!keys || !batches || !next)) {
+        fprintf(stderr, "Error: Draw list sort allocation failed, keeping submission order.\n");
+        for (size_t i = 0; i < count; i++) list->order[i] = i;
+        free(keys);
+        free(batches);
+        free(next);
+        list->stats.stateChangesAfter = list->stats.stateChangesBefore;
+        BuildDrawCalls(list);
+        list->stats.drawCalls = list->callCount;
+        return;
+    }
+
+    // Layers are strict painter order, so group by them first
+    for (size_t i = 0; i < count; i++) keys[i] = (LayerKey){commands[i].layer, i};
+    qsort(keys, count, sizeof(LayerKey), CompareLayerKeys);
+
+    size_t batchCount = 0;
+    size_t runStart = 0;
+
+    while (runStart < count) {
+        size_t runEnd = runStart;
+        while (runEnd < count && keys[runEnd].layer == keys[runStart].layer) runEnd++;
+
+        size_t layerBatches = batchCount;
+
+        // Append every command to the newest batch with matching state it can legally reach,
+        // it may only skip past batches it does not overlap
+        for (size_t k = runStart; k < runEnd; k++) {
+            size_t index = keys[k].index;
+            const DrawCommand* command = &commands[index];
+            size_t stop = batchCount - layerBatches > DRAW_SORT_LOOKBACK ? batchCount - DRAW_SORT_LOOKBACK : layerBatches;
+            size_t found = batchCount;
+
+            for (size_t b = batchCount; b > stop; b--) {
+                DrawBatch* batch = &batches[b - 1];
+                if (DrawCommandsMatch(&commands[batch->head], command) && TexturesMatch(batch->texture, command->texture)) {
+                    found = b - 1;
+                    break;
+                }
+                if (BatchOverlapsRect(commands, next, count, batch, command->bounds)) break;
+            }
+
+            next[index] = count;
+            if (found < batchCount) {
+                next[batches[found].tail] = index;
+                batches[found].tail = index;
+                batches[found].bounds = RectUnion(batches[found].bounds, command->bounds);
+                if (!batches[found].texture) batches[found].texture = command->texture;
+            } else {
+                batches[batchCount++] = (DrawBatch){index, index, command->texture, command->bounds};
+            }
+        }
+
+        // Order the batches of this layer by state, again only past batches they do not overlap
+        for (size_t b = layerBatches + 1; b < batchCount; b++) {
+            DrawBatch moving = batches[b];
+            size_t position = b;
+
+            while (position > layerBatches && b - position < DRAW_SORT_LOOKBACK &&
+                   BatchLess(commands, &moving, &batches[position - 1]) &&
+                   !BatchesOverlap(commands, next, count, &moving, &batches[position - 1])) {
+                batches[position] = batches[position - 1];
+                position--;
+            }
+            batches[position] = moving;
+        }
+
+        runStart = runEnd;
+    }
+
+    size_t written = 0;
+    for (size_t b = 0; b < batchCount; b++) {
+        for (size_t index = batches[b].head; index != count; index = next[index]) {
+            list->order[written++] = index;
+        }
+    }
+
+    free(keys);
+    free(batches);
+    free(next);
+
+    list->stats.stateChangesAfter = CountStateChanges(commands, list->order, count);
+    BuildDrawCalls(list);
+    list->stats.drawCalls = list->callCount;
+}
@@ -0,0 +1,129 @@
+#ifndef DRAWLIST_H
+#define DRAWLIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "types.h"
+
+// Layers are always drawn in order, the sort never moves a command across layers
+typedef enum {
+    DRAW_LAYER_BACKGROUND,
+    DRAW_LAYER_CONTENT,
+    DRAW_LAYER_OVERLAY
+} DrawLayer;
+
+typedef enum {
+    DRAW_BLEND_NONE,
+    DRAW_BLEND_ALPHA
+} DrawBlend;
+
+// What the UI program draws for a vertex. It is stored per vertex so any mix of primitives can share one draw.
+typedef enum {
+    DRAW_KIND_GLYPH,        // Color times the red channel of the texture
+    DRAW_KIND_SOLID,        // Color only
+    DRAW_KIND_ROUNDED_RECT, // Color masked by the rounded rect in shape
+    DRAW_KIND_IMAGE         // Color times the texture
+} DrawKind;
+
+// One vertex as the UI program sees it, <vec2 pos, vec2 tex>, <float kind>, <vec3 shape>, <vec4 color>.
+// Rounded rects use u, v as the offset from the rect center in pixels and shape as <half width, half height, radius>.
+// Color travels with the vertex, so primitives of any color share one draw.
+typedef struct DrawVertex {
+    float x, y;
+    float u, v;
+    float kind;
+    float shape[3];
+    uint8_t color[4]; // RGBA, normalized by the vertex stage
+} DrawVertex;
+
+// A run of vertices that share all of their render state
+typedef struct DrawCommand {
+    DrawLayer layer;
+    unsigned int program;
+    unsigned int texture; // 0 when no vertex samples, such commands merge with any texture
+    DrawBlend blend;
+    Color color;      // Written into every vertex of the command, never splits a draw
+    Rect bounds;      // Screen space area touched by the vertices
+    size_t firstVertex;
+    size_t vertexCount;
+} DrawCommand;
+
+// A merged run of commands, vertices live in sortedVertices
+typedef struct DrawCall {
+    size_t command;       // Index of a command holding the render state of the call
+    unsigned int texture; // Texture of the call, the command may not sample any
+    size_t firstVertex;
+    size_t vertexCount;
+} DrawCall;
+
+typedef struct DrawListStats {
+    size_t commandCount;
+    size_t drawCalls;
+    size_t stateChangesBefore; // Program, texture and blend switches in submission order
+    size_t stateChangesAfter;  // The same count after SortDrawList
+    size_t culled;             // Primitives and subtrees skipped because they were outside the clip
+} DrawListStats;
+
+// All draw commands of a frame, vertices are stored in submission order
+typedef struct DrawList {
+    DrawVertex* vertices;
+    size_t vertexCount;
+    size_t vertexCapacity;
+
+    DrawCommand* commands;
+    size_t commandCount;
+    size_t commandCapacity;
+
+    // Command indices in the order they should be drawn, valid after SortDrawList
+    size_t* order;
+    size_t orderCapacity;
+
+    // Vertices in draw order and the draw calls covering them, valid after SortDrawList
+    DrawVertex* sortedVertices;
+    size_t sortedCapacity;
+    DrawCall* calls;
+    size_t callCount;
+    size_t callCapacity;
+
+    // Clip rects while recording, each one already intersected with the one below
+    Rect* clips;
+    size_t clipCount;
+    size_t clipCapacity;
+
+    DrawListStats stats;
+} DrawList;
+
+void InitDrawList(DrawList* list);
+// Empties the list but keeps its memory for the next frame
+void ClearDrawList(DrawList* list);
+void FreeDrawList(DrawList* list);
+
+// Copies the vertices into the list and records a command for them, returns 1 on failure
+int PushDrawCommand(DrawList* list, const DrawCommand* state, const DrawVertex* vertices, size_t vertexCount);
+
+// Restricts everything recorded until the matching PopDrawClip to rect, on top of the current clip.
+// Every primitive is an axis aligned quad, so quads are cut to the clip on the CPU with their texture
+// coordinates adjusted. That is exactly what a scissor rect would do, without splitting batches by scissor state.
+void PushDrawClip(DrawList* list, Rect rect);
+void PopDrawClip(DrawList* list);
+// If anything inside of rect would survive the current clip, lets callers skip whole subtrees
+int DrawClipVisible(const DrawList* list, Rect rect);
+// The current clip, an endless rect when nothing was pushed
+Rect GetDrawClip(const DrawList* list);
+
+// Records an axis aligned quad of one kind, uv is the texture area it samples.
+// Quads outside of the clip are dropped and counted in stats.culled.
+int PushDrawQuad(DrawList* list, const DrawCommand* state, DrawKind kind, Rect rect, Rect uv);
+// Records a rect with corners rounded by radius, edges are antialiased by the fragment stage
+int PushDrawRoundedRect(DrawList* list, const DrawCommand* state, Rect rect, float radius);
+
+// Reorders commands by (layer, program, texture, blend) to cut state changes.
+// Two commands only trade places when their bounds do not intersect, so overlapping content keeps its painter order.
+// Afterwards neighbouring commands with the same state are merged into calls.
+void SortDrawList(DrawList* list);
+
+// If two commands can be drawn with a single draw call, commands without a texture match any texture
+int DrawCommandsMatch(const DrawCommand* a, const DrawCommand* b);
+
+#endif
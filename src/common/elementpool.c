@@ -0,0 +1,107 @@
+#include "elementpool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void InitElementPool(ElementPool* pool) {
+    memset(pool, 0, sizeof(ElementPool));
+    pool->free = ELEMENT_SLOT_NONE;
+}
+
+void FreeElementPool(ElementPool* pool) {
+    for (uint32_t i = 0; i < pool->count; i++) {
+        ElementSlot* slot = GetElementSlot(pool, i);
+        if (!slot->used) continue;
+        if (slot->element.type == SECTION) free(slot->data.section.children);
+        free(slot->characters);
+    }
+    for (size_t i = 0; i < pool->blockCount; i++) free(pool->blocks[i]);
+    free(pool->blocks);
+    InitElementPool(pool);
+}
+
+ElementSlot* GetElementSlot(const ElementPool* pool, uint32_t index) {
+    return &pool->blocks[index / ELEMENT_POOL_BLOCK][index % ELEMENT_POOL_BLOCK];
+}
+
+// Hands out a slot from the free list, or a new one from the newest block
+static ElementSlot* TakeSlot(ElementPool* pool, uint32_t* index) {
+    if (pool->free != ELEMENT_SLOT_NONE) {
+        *index = pool->free;
+        ElementSlot* slot = GetElementSlot(pool, *index);
+        pool->free = slot->nextFree;
+        return slot;
+    }
+
+    if (pool->count == ELEMENT_SLOT_NONE) return NULL;
+    if (pool->count == pool->blockCount * ELEMENT_POOL_BLOCK) {
+        ElementSlot** blocks = realloc(pool->blocks, (pool->blockCount + 1) * sizeof(ElementSlot*));
+        if (blocks == NULL) return NULL;
+        pool->blocks = blocks;
+
+        ElementSlot* block = malloc(ELEMENT_POOL_BLOCK * sizeof(ElementSlot));
+        if (block == NULL) return NULL;
+        pool->blocks[pool->blockCount++] = block;
+    }
+
+    *index = pool->count++;
+    ElementSlot* slot = GetElementSlot(pool, *index);
+    slot->generation = 1;
+    return slot;
+}
+
+ElementSlot* AcquireElementSlot(ElementPool* pool, ElementType type, uint32_t parent) {
+    uint32_t index;
+    ElementSlot* slot = TakeSlot(pool, &index);
+    if (slot == NULL) {
+        fprintf(stderr, "Error: Element pool allocation failed.\n");
+        return NULL;
+    }
+
+    memset(&slot->data, 0, sizeof(slot->data));
+    slot->element = (Element){
+        .type = type,
+        .data = &slot->data,
+        .bounds = {{0, 0}, {0, 0}},
+        .spatial = NULL,
+        .slot = index
+    };
+    slot->characters = NULL;
+    slot->key = 0;
+    slot->described = false;
+    slot->parent = parent;
+    slot->used = true;
+    pool->live++;
+    return slot;
+}
+
+void ReleaseElementSlot(ElementPool* pool, uint32_t index) {
+    ElementSlot* slot = GetElementSlot(pool, index);
+    if (!slot->used) return;
+
+    if (slot->element.type == SECTION) free(slot->data.section.children);
+    free(slot->characters);
+    slot->used = false;
+    // 0 marks the null handle, so a wrapped generation skips it
+    if (++slot->generation == 0) slot->generation = 1;
+    slot->nextFree = pool->free;
+    pool->free = index;
+    pool->live--;
+}
+
+void ResetElementPool(ElementPool* pool) {
+    for (uint32_t i = 0; i < pool->count; i++) ReleaseElementSlot(pool, i);
+}
+
+ElementSlot* ResolveElementHandle(const ElementPool* pool, ElementHandle handle) {
+    if (handle.index >= pool->count) return NULL;
+
+    ElementSlot* slot = GetElementSlot(pool, handle.index);
+    if (!slot->used || slot->generation != handle.generation) return NULL;
+    return slot;
+}
+
+ElementHandle GetSlotHandle(const ElementSlot* slot) {
+    return (ElementHandle){slot->element.slot, slot->generation};
+}
@@ -0,0 +1,58 @@
+#ifndef ELEMENTPOOL_H
+#define ELEMENTPOOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "elements.h"
+#include "types.h"
+
+// Slots are carved out of blocks this many at a time
+#define ELEMENT_POOL_BLOCK 256
+
+// An element and its payload in one piece, so spawning one takes no allocation
+typedef struct ElementSlot {
+    Element element; // element.slot is the index of this slot
+    union {
+        Text text;
+        Section section;
+        Button button;
+        Image image;
+    } data;
+    Text label;          // Label of described buttons, data.button.text points here
+    char* characters;    // Copy of the text, label or image path of described elements, freed with the slot
+    uint64_t key;        // Key of described elements
+    bool described;      // Owned by the description of the window, see SubmitDescription
+    uint32_t parent;     // Slot of the section holding the element, ELEMENT_SLOT_NONE for the window itself
+    uint32_t generation; // Bumped every time the slot is released
+    uint32_t nextFree;
+    bool used;
+} ElementSlot;
+
+// Blocks never move, so Element pointers into the pool stay valid while the slot is used.
+// Released slots go on a free list and are handed out again before the pool grows.
+typedef struct ElementPool {
+    ElementSlot** blocks;
+    size_t blockCount;
+    uint32_t count; // Slots handed out at least once
+    uint32_t live;
+    uint32_t free;  // First free slot, ELEMENT_SLOT_NONE when there is none
+} ElementPool;
+
+void InitElementPool(ElementPool* pool);
+void FreeElementPool(ElementPool* pool);
+
+// Returns a used slot with a fresh element of type whose data points at the payload, or NULL when the pool can not grow
+ElementSlot* AcquireElementSlot(ElementPool* pool, ElementType type, uint32_t parent);
+// Frees the child array of sections, the slot's handles go stale
+void ReleaseElementSlot(ElementPool* pool, uint32_t index);
+// Releases every used slot
+void ResetElementPool(ElementPool* pool);
+
+ElementSlot* GetElementSlot(const ElementPool* pool, uint32_t index);
+// Returns NULL for handles that are stale or were never handed out
+ElementSlot* ResolveElementHandle(const ElementPool* pool, ElementHandle handle);
+ElementHandle GetSlotHandle(const ElementSlot* slot);
+
+#endif
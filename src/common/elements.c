@@ -1,37 +1,192 @@
 #include "elements.h"
 
 #include <stdio.h>
+#include <string.h>
+
+static _Thread_local Arena* elementArena;
+
+void SetElementArena(Arena* arena) {
+    elementArena = arena;
+}
+
+Arena* GetElementArena() {
+    return elementArena;
+}
+
+static void* ElementAlloc(size_t size) {
+    return elementArena ? ArenaAlloc(elementArena, size) : malloc(size);
+}
+
+// Arena trees own their strings so the whole tree goes away at once, heap ones keep borrowing them
+static char* ElementString(char* string) {
+    return elementArena && string ? ArenaCopyString(elementArena, string) : string;
+}
 
 int ResizeElementsArray(Element*** arrayPtr, size_t* countPrt, size_t newCount) {
     Element** temp = (Element**)realloc(*arrayPtr, newCount * sizeof(Element*));
 
     if (temp == NULL) {
         fprintf(stderr, "Error: Memory reallocation failed. Array remains unchanged.\n");
-        
-        return 1; 
+
+        return 1;
     }
 
     *arrayPtr = temp;
-    *countPrt = (int)newCount;
+    *countPrt = newCount;
     return 0;
 }
 
+int GrowElementsArray(Element*** arrayPtr, size_t* capacity, size_t needed) {
+    if (needed <= *capacity) return 0;
+
+    size_t grown = *capacity ? *capacity : 4;
+    while (grown < needed) grown *= 2;
+    return ResizeElementsArray(arrayPtr, capacity, grown);
+}
+
 Element* CreateUniqueElement(ElementType type, void* data) {
-    Element* element = (Element*)malloc(sizeof(Element));
+    Element* element = (Element*)ElementAlloc(sizeof(Element));
     element->data = data;
     element->type = type;
+    element->bounds = (Rect){{0, 0}, {0, 0}};
+    element->spatial = NULL;
+    element->slot = ELEMENT_SLOT_NONE;
     return element;
 }
 
-Text* CreateText(char* text, float scale, Color color) {
-    Text* txt = (Text*)malloc(sizeof(Text));
-    txt->text
+// ----------- Text -----------
+
+Text* CreateText(Vector2 size, char* text, float scale, Color color) {
+    return CreateTextView(size, ViewString(ElementString(text)), scale, color);
+}
+
+Text* CreateTextView(Vector2 size, StringView view, float scale, Color color) {
+    Text* txt = (Text*)ElementAlloc(sizeof(Text));
+    txt->size = size;
+    txt->text = view.data;
+    txt->length = view.length;
+    txt->id = 0;
+    txt->scale = scale;
+    txt->color = color;
+    return txt;
+}
+
+void SetTextView(Text* text, StringView view) {
+    text->text = view.data;
+    text->length = view.length;
+    text->id = 0;
+}
+
+StringView ViewString(const char* string) {
+    return (StringView){string, string ? strlen(string) : 0};
+}
+
+Element* CreateTextElement(Text* text) {
+    return CreateUniqueElement(TEXT, text);
 }
-Element* CreateTextElement(Text* text);
 
-Section* CreateSection(Vector2 size, Color color, Element* child);
-void AddSectionChild(Section* section, Element* newChild);
-Element* CreateSectionElement(Section* section);
+// ----------- Section -----------
+
+Section* CreateSection(Vector2 size, Color color, Element* child) {
+    Section* section = (Section*)ElementAlloc(sizeof(Section));
+    section->size = size;
+    section->color = color;
+    section->scroll = (Vector2){0, 0};
+    section->children = NULL;
+    section->childrenCount = 0;
+    section->childrenCapacity = 0;
+    section->arena = elementArena;
 
-Section* CreateButton(Vector2 size, Color color, Text* text, void (*onClick)(void));
-Element* CreateButtonElement(Button* button);
+    if (child) AddSectionChild(section, child);
+
+    return section;
+}
+
+static int ReserveChildren(Section* section, size_t needed) {
+    if (needed <= section->childrenCapacity) return 0;
+    if (!section->arena) return GrowElementsArray(&section->children, &section->childrenCapacity, needed);
+
+    // Arena memory can not be reallocated, the old array stays behind until the arena is reset
+    size_t capacity = section->childrenCapacity ? section->childrenCapacity : 4;
+    while (capacity < needed) capacity *= 2;
+    Element** children = ArenaAlloc(section->arena, capacity * sizeof(Element*));
+    if (children == NULL) return 1;
+    if (section->childrenCount) memcpy(children, section->children, section->childrenCount * sizeof(Element*));
+    section->children = children;
+    section->childrenCapacity = capacity;
+    return 0;
+}
+
+void AddSectionChild(Section* section, Element* newChild) {
+    if (ReserveChildren(section, section->childrenCount + 1)) return;
+    section->children[section->childrenCount++] = newChild;
+}
+
+void AddSectionChildren(Section* section, Element** children, size_t count) {
+    if (count == 0 || ReserveChildren(section, section->childrenCount + count)) return;
+    memcpy(section->children + section->childrenCount, children, count * sizeof(Element*));
+    section->childrenCount += count;
+}
+
+Element* CreateSectionElement(Section* section) {
+    return CreateUniqueElement(SECTION, section);
+}
+
+// ----------- Button -----------
+
+Button* CreateButton(Vector2 size, Color color, Text* text, void (*onClick)(void)) {
+    Button* button = (Button*)ElementAlloc(sizeof(Button));
+    button->size = size;
+    button->color = color;
+    button->text = text;
+    button->onClick = onClick;
+    return button;
+}
+
+Element* CreateButtonElement(Button* button) {
+    return CreateUniqueElement(BUTTON, button);
+}
+
+// ----------- Image -----------
+
+Image* CreateImage(Vector2 size, char* path) {
+    Image* image = (Image*)ElementAlloc(sizeof(Image));
+    image->size = size;
+    image->path = ElementString(path);
+    image->tint = (Color){255, 255, 255, 255};
+    image->resource = NULL;
+    return image;
+}
+
+Element* CreateImageElement(Image* image) {
+    return CreateUniqueElement(IMAGE, image);
+}
+
+// ----------- Layout -----------
+
+static Vector2 ElementSize(const Element* element) {
+    switch (element->type) {
+        case TEXT:    return ((Text*)element->data)->size;
+        case SECTION: return ((Section*)element->data)->size;
+        case BUTTON:  return ((Button*)element->data)->size;
+        case IMAGE:   return ((Image*)element->data)->size;
+    }
+    return (Vector2){0, 0};
+}
+
+void LayoutElements(Element** elements, size_t count, Rect area) {
+    float cursor = area.position.y;
+
+    for (size_t i = 0; i < count; i++) {
+        Element* element = elements[i];
+
+        element->bounds.position = (Vector2){area.position.x, cursor};
+        element->bounds.size = ElementSize(element);
+        cursor += element->bounds.size.y;
+
+        if (element->type == SECTION) {
+            Section* section = element->data;
+            LayoutElements(section->children, section->childrenCount, element->bounds);
+        }
+    }
+}
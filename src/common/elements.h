@@ -4,40 +4,71 @@
 #include <stdlib.h>
 
 #include "types.h"
+#include "arena.h"
 
-typedef struct  {
+typedef enum {
+    TEXT, SECTION, BUTTON, IMAGE
+} ElementType;
+
+// Slot of elements that were not spawned from a window's pool
+#define ELEMENT_SLOT_NONE UINT32_MAX
+
+typedef struct Element {
     ElementType type;
     void* data;
+    Rect bounds; // Filled in by LayoutElements, top-left origin in pixels, before any section scrolls it
+    struct QuadtreeItem* spatial; // Entry in the spatial index of the window showing the element
+    uint32_t slot; // Index in the element pool of the window, ELEMENT_SLOT_NONE when created some other way
 } Element;
 
-typedef enum {
-    TEXT, SECTION, BUTTON
-} ElementType;
-
 int ResizeElementsArray(Element*** arrayPtr, size_t* countPrt, size_t newCount);
+// Doubles capacity until needed elements fit, so filling an array one by one stays linear
+int GrowElementsArray(Element*** arrayPtr, size_t* capacity, size_t needed);
+
+// While an arena is set, the Create functions of the calling thread allocate elements, payloads,
+// child arrays and copies of their strings from it instead of the heap. NULL goes back to malloc.
+void SetElementArena(Arena* arena);
+Arena* GetElementArena();
 
 // Creates an element from types not already defined
 Element* CreateUniqueElement(ElementType type, void* data);
 
 typedef struct Text {
+    Vector2 size;
     float scale;
-    char* text;
+    const char* text; // length characters, not necessarily 0 terminated
+    size_t length;
+    StringId id;      // Interned string the characters belong to, 0 when they are not interned
     Color color;
 } Text;
 
-Text* CreateText(char* text, float scale, Color color);
+Text* CreateText(Vector2 size, char* text, float scale, Color color);
+// Shows the characters of view without copying them, even in an arena. The memory has to stay
+// unchanged and alive until the text is freed or shows something else.
+Text* CreateTextView(Vector2 size, StringView view, float scale, Color color);
+// Points text at new characters, same contract as CreateTextView. Call between LockWindow and UnlockWindow.
+void SetTextView(Text* text, StringView view);
+StringView ViewString(const char* string);
 Element* CreateTextElement(Text* text);
 
 
+// Children are clipped to the section, scroll moves them up and left inside of it.
+// Scrolling is applied when the section is drawn and hit tested, the layout stays as it was, so change scroll
+// between LockWindow and UnlockWindowAfter(window, WINDOW_CHANGED_PAINT).
 typedef struct Section {
     Vector2 size;
     Color color;
+    Vector2 scroll;
     Element** children;
-    int childrenCount;
+    size_t childrenCount;
+    size_t childrenCapacity;
+    Arena* arena; // Holds the section and its child array when it was created in one
 } Section;
 
 Section* CreateSection(Vector2 size, Color color, Element* child);
 void AddSectionChild(Section* section, Element* newChild);
+// Adds count children with at most one allocation
+void AddSectionChildren(Section* section, Element** children, size_t count);
 Element* CreateSectionElement(Section* section);
 
 typedef struct Button {
@@ -47,7 +78,22 @@ typedef struct Button {
     void (*onClick)(void);
 } Button;
 
-Section* CreateButton(Vector2 size, Color color, Text* text, void (*onClick)(void));
+Button* CreateButton(Vector2 size, Color color, Text* text, void (*onClick)(void));
 Element* CreateButtonElement(Button* button);
 
-#endif
\ No newline at end of file
+// A picture file drawn stretched over size, tinted by multiplying with tint.
+// The file is decoded in the background once the image is added to a window, nothing is drawn until it is ready.
+typedef struct Image {
+    Vector2 size;
+    char* path;
+    Color tint;
+    struct ImageResource* resource; // Decoded pixels shared by every image of the same path, set by the window
+} Image;
+
+Image* CreateImage(Vector2 size, char* path);
+Element* CreateImageElement(Image* image);
+
+// Lays elements out top to bottom inside of area, sections lay out their children the same way without their scroll
+void LayoutElements(Element** elements, size_t count, Rect area);
+
+#endif
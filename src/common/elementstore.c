@@ -0,0 +1,174 @@
+#include "elementstore.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void InitElementStore(ElementStore* store) {
+    memset(store, 0, sizeof(ElementStore));
+}
+
+void FreeElementStore(ElementStore* store) {
+    free(store->types);
+    free(store->sizes);
+    free(store->parents);
+    free(store->nextSiblings);
+    free(store->ends);
+    free(store->bounds);
+    free(store->flags);
+    free(store->colors);
+    free(store->texts);
+    free(store->paintVersions);
+    free(store->sources);
+    free(store->cursors);
+    free(store->openEnds);
+    free(store->openScrolls);
+    InitElementStore(store);
+}
+
+static int GrowComponent(void** array, size_t capacity, size_t elementSize) {
+    void* grown = realloc(*array, capacity * elementSize);
+    if (grown == NULL) return 1;
+    *array = grown;
+    return 0;
+}
+
+static int ReserveElements(ElementStore* store, size_t needed) {
+    if (needed <= store->capacity) return 0;
+
+    size_t capacity = store->capacity ? store->capacity : 256;
+    while (capacity < needed) capacity *= 2;
+
+    // Arrays that already grew keep working with the old capacity if a later one fails
+    if (GrowComponent((void**)&store->types, capacity, sizeof(uint8_t)) ||
+        GrowComponent((void**)&store->sizes, capacity, sizeof(Vector2)) ||
+        GrowComponent((void**)&store->parents, capacity, sizeof(uint32_t)) ||
+        GrowComponent((void**)&store->nextSiblings, capacity, sizeof(uint32_t)) ||
+        GrowComponent((void**)&store->ends, capacity, sizeof(uint32_t)) ||
+        GrowComponent((void**)&store->bounds, capacity, sizeof(Rect)) ||
+        GrowComponent((void**)&store->flags, capacity, sizeof(uint8_t)) ||
+        GrowComponent((void**)&store->colors, capacity, sizeof(Color)) ||
+        GrowComponent((void**)&store->texts, capacity, sizeof(Text*)) ||
+        GrowComponent((void**)&store->paintVersions, capacity, sizeof(uint32_t)) ||
+        GrowComponent((void**)&store->sources, capacity, sizeof(Element*)) ||
+        GrowComponent((void**)&store->cursors, capacity, sizeof(float)) ||
+        GrowComponent((void**)&store->openEnds, capacity, sizeof(uint32_t)) ||
+        GrowComponent((void**)&store->openScrolls, capacity, sizeof(Vector2))) {
+        fprintf(stderr, "Error: Element store allocation failed.\n");
+        return 1;
+    }
+
+    store->capacity = capacity;
+    return 0;
+}
+
+static Vector2 SourceSize(const Element* element) {
+    switch (element->type) {
+        case TEXT:    return ((Text*)element->data)->size;
+        case SECTION: return ((Section*)element->data)->size;
+        case BUTTON:  return ((Button*)element->data)->size;
+        case IMAGE:   return ((Image*)element->data)->size;
+    }
+    return (Vector2){0, 0};
+}
+
+static void CopyPaint(ElementStore* store, uint32_t index, const Element* element) {
+    Color color = {0, 0, 0, 0};
+    Text* text = NULL;
+    uint8_t flags = 0;
+
+    switch (element->type) {
+        case TEXT:
+            text = element->data;
+            break;
+        case SECTION:
+            color = ((Section*)element->data)->color;
+            flags = ELEMENT_FLAG_CLIPS;
+            break;
+        case BUTTON: {
+            Button* button = element->data;
+            color = button->color;
+            text = button->text;
+            break;
+        }
+        case IMAGE:
+            color = ((Image*)element->data)->tint;
+            break;
+    }
+    if (element->type != IMAGE && color.alpha) flags |= ELEMENT_FLAG_FILL;
+
+    store->flags[index] = flags;
+    store->colors[index] = color;
+    store->texts[index] = text;
+    store->paintVersions[index] = store->paintVersion;
+}
+
+static void CopyComponents(ElementStore* store, uint32_t index, Element* element, uint32_t parent) {
+    CopyPaint(store, index, element);
+    store->sizes[index] = SourceSize(element);
+    store->types[index] = (uint8_t)element->type;
+    store->parents[index] = parent;
+    store->nextSiblings[index] = ELEMENT_NONE;
+    store->bounds[index] = (Rect){{0, 0}, store->sizes[index]};
+    store->sources[index] = element;
+}
+
+static int FlattenChildren(ElementStore* store, Element** elements, size_t count, uint32_t parent) {
+    uint32_t previous = ELEMENT_NONE;
+
+    for (size_t i = 0; i < count; i++) {
+        if (store->count >= ELEMENT_NONE || ReserveElements(store, store->count + 1)) return 1;
+
+        uint32_t index = (uint32_t)store->count++;
+        CopyComponents(store, index, elements[i], parent);
+        if (previous != ELEMENT_NONE) store->nextSiblings[previous] = index;
+        previous = index;
+
+        if (elements[i]->type == SECTION) {
+            Section* section = elements[i]->data;
+            if (FlattenChildren(store, section->children, section->childrenCount, index)) return 1;
+        }
+        store->ends[index] = (uint32_t)store->count;
+    }
+    return 0;
+}
+
+int FlattenElements(ElementStore* store, Element** elements, size_t count) {
+    store->count = 0;
+    return FlattenChildren(store, elements, count, ELEMENT_NONE);
+}
+
+void RefreshElementSizes(ElementStore* store) {
+    for (size_t i = 0; i < store->count; i++) store->sizes[i] = SourceSize(store->sources[i]);
+}
+
+void InvalidateElementPaint(ElementStore* store) {
+    store->paintVersion++;
+}
+
+void RefreshElementPaint(ElementStore* store, uint32_t index) {
+    if (store->paintVersions[index] != store->paintVersion) CopyPaint(store, index, store->sources[index]);
+}
+
+void LayoutElementStore(ElementStore* store, Rect area) {
+    float top = area.position.y;
+    const uint32_t* parents = store->parents;
+    const Vector2* sizes = store->sizes;
+    Rect* bounds = store->bounds;
+    float* cursors = store->cursors;
+
+    // Parents come first, so their bounds and the cursor of their content are ready for every child
+    for (size_t i = 0; i < store->count; i++) {
+        uint32_t parent = parents[i];
+        float x = area.position.x;
+        float* cursor = &top;
+        if (parent != ELEMENT_NONE) {
+            x = bounds[parent].position.x;
+            cursor = &cursors[parent];
+        }
+
+        bounds[i] = (Rect){{x, *cursor}, sizes[i]};
+        *cursor += sizes[i].y;
+        cursors[i] = bounds[i].position.y;
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef ELEMENTSTORE_H
+#define ELEMENTSTORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "elements.h"
+#include "types.h"
+
+// Marks a missing parent or sibling
+#define ELEMENT_NONE UINT32_MAX
+
+typedef enum {
+    ELEMENT_FLAG_FILL  = 1 << 0, // Draws its color as a background
+    ELEMENT_FLAG_CLIPS = 1 << 1  // Clips its children, sections
+} ElementFlags;
+
+// The components of an element tree in parallel arrays in pre-order, so passes stream through memory
+// instead of chasing two pointers per element. A parent always comes before its children and the
+// subtree of i is [i, ends[i]), so its first child is i + 1 whenever ends[i] > i + 1.
+typedef struct ElementStore {
+    size_t count;
+    size_t capacity;
+
+    // Read by layout
+    uint8_t* types; // ElementType
+    Vector2* sizes;
+    uint32_t* parents;
+    uint32_t* nextSiblings;
+    uint32_t* ends;
+    Rect* bounds; // Written by LayoutElementStore
+
+    // Read by drawing, copied again from the sources when an element is drawn after InvalidateElementPaint
+    uint8_t* flags; // ElementFlags
+    Color* colors;  // Section and button fills, image tints
+    Text** texts;   // Text elements and button labels
+    uint32_t* paintVersions; // The paintVersion the three above were copied at
+    uint32_t paintVersion;
+    Element** sources; // The elements the components were copied from, drawing reads section scrolls from them
+
+    // Scratch space of layout and drawing, one entry per element
+    float* cursors;
+    uint32_t* openEnds;
+    Vector2* openScrolls;
+} ElementStore;
+
+void InitElementStore(ElementStore* store);
+void FreeElementStore(ElementStore* store);
+
+// Copies the tree under elements into the store, returns 1 when the arrays could not grow
+int FlattenElements(ElementStore* store, Element** elements, size_t count);
+// Copies the sizes of the elements again, for size changes that left the tree itself as it was
+void RefreshElementSizes(ElementStore* store);
+// Marks the colors and texts of every element as changed without touching the arrays,
+// so a paint change only costs as much as the elements drawn afterwards
+void InvalidateElementPaint(ElementStore* store);
+// Copies the colors and texts of an element again if they were marked as changed since the last copy
+void RefreshElementPaint(ElementStore* store, uint32_t index);
+// Same result as LayoutElements in a single pass over the arrays
+void LayoutElementStore(ElementStore* store, Rect area);
+
+#endif
@@ -0,0 +1,85 @@
+#include "gputimer.h"
+
+#include <glad/glad.h>
+
+#include <string.h>
+
+void GpuTimerInit(GpuTimer* timer, int stageCount) {
+    memset(timer, 0, sizeof(GpuTimer));
+    timer->stageCount = stageCount < GPU_TIMER_MAX_STAGES ? stageCount : GPU_TIMER_MAX_STAGES;
+    timer->active = -1;
+
+    for (int frame = 0; frame < GPU_TIMER_FRAMES; frame++) {
+        glGenQueries(timer->stageCount, timer->queries[frame]);
+    }
+    timer->ready = true;
+}
+
+void GpuTimerDestroy(GpuTimer* timer) {
+    if (!timer->ready) return;
+
+    GpuTimerEndStage(timer);
+    for (int frame = 0; frame < GPU_TIMER_FRAMES; frame++) {
+        glDeleteQueries(timer->stageCount, timer->queries[frame]);
+    }
+    timer->ready = false;
+}
+
+static bool FrameIssued(const GpuTimer* timer, int frame) {
+    for (int stage = 0; stage < timer->stageCount; stage++) {
+        if (timer->issued[frame][stage]) return true;
+    }
+    return false;
+}
+
+// Reads a finished frame and frees its slot, returns false without waiting when the GPU is not done with it
+static bool CollectFrame(GpuTimer* timer, int frame) {
+    for (int stage = 0; stage < timer->stageCount; stage++) {
+        if (!timer->issued[frame][stage]) continue;
+
+        GLint available = 0;
+        glGetQueryObjectiv(timer->queries[frame][stage], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) return false;
+    }
+
+    for (int stage = 0; stage < timer->stageCount; stage++) {
+        GLuint64 nanoseconds = 0;
+        if (timer->issued[frame][stage]) glGetQueryObjectui64v(timer->queries[frame][stage], GL_QUERY_RESULT, &nanoseconds);
+        timer->milliseconds[stage] = nanoseconds / 1e6;
+    }
+    memset(timer->issued[frame], 0, sizeof(timer->issued[frame]));
+    return true;
+}
+
+void GpuTimerBeginFrame(GpuTimer* timer) {
+    GpuTimerEndStage(timer);
+
+    // Oldest first, so milliseconds ends up holding the newest finished frame
+    for (int age = 1; age <= GPU_TIMER_FRAMES; age++) {
+        int frame = (timer->frame + age) % GPU_TIMER_FRAMES;
+        if (FrameIssued(timer, frame) && !CollectFrame(timer, frame)) break;
+    }
+
+    timer->frame = (timer->frame + 1) % GPU_TIMER_FRAMES;
+    // Still unfinished after GPU_TIMER_FRAMES frames, reusing its queries drops those results
+    if (FrameIssued(timer, timer->frame)) {
+        timer->framesDropped++;
+        memset(timer->issued[timer->frame], 0, sizeof(timer->issued[timer->frame]));
+    }
+}
+
+void GpuTimerStage(GpuTimer* timer, int stage) {
+    GpuTimerEndStage(timer);
+    if (stage < 0 || stage >= timer->stageCount) return;
+
+    glBeginQuery(GL_TIME_ELAPSED, timer->queries[timer->frame][stage]);
+    timer->issued[timer->frame][stage] = true;
+    timer->active = stage;
+}
+
+void GpuTimerEndStage(GpuTimer* timer) {
+    if (!timer->ready || timer->active < 0) return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    timer->active = -1;
+}
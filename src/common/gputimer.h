@@ -0,0 +1,37 @@
+#ifndef GPUTIMER_H
+#define GPUTIMER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Most stages a timer can tell apart
+#define GPU_TIMER_MAX_STAGES 8
+// Frames of queries kept in flight, results are read this many frames after they were issued so reading never stalls
+#define GPU_TIMER_FRAMES 4
+
+// Times stages of a frame with GL_TIME_ELAPSED queries.
+// Queries are not shared between contexts, so every window needs its own timer.
+typedef struct GpuTimer {
+    bool ready;
+    int stageCount;
+    unsigned int queries[GPU_TIMER_FRAMES][GPU_TIMER_MAX_STAGES];
+    bool issued[GPU_TIMER_FRAMES][GPU_TIMER_MAX_STAGES];
+    int frame;  // Slot of the frame being recorded
+    int active; // Stage whose query is running, -1 when none is
+
+    double milliseconds[GPU_TIMER_MAX_STAGES]; // Of the newest frame whose results arrived
+    uint64_t framesDropped;                    // Frames whose results were not ready when their slot came around again
+} GpuTimer;
+
+// The context the timer is used with has to be current for all of these
+void GpuTimerInit(GpuTimer* timer, int stageCount);
+void GpuTimerDestroy(GpuTimer* timer);
+
+// Starts recording a frame, collecting the results of the frame that used this slot before
+void GpuTimerBeginFrame(GpuTimer* timer);
+// Ends the running stage and starts timing stage, stages can not nest
+void GpuTimerStage(GpuTimer* timer, int stage);
+// Ends the running stage
+void GpuTimerEndStage(GpuTimer* timer);
+
+#endif
@@ -0,0 +1,205 @@
+#include "headless.h"
+
+#include <glad/glad.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef GUILAY_HEADLESS
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+static EGLDisplay display = EGL_NO_DISPLAY;
+static EGLConfig config;
+
+// ----------- Init / Exit -----------
+
+static EGLDisplay OpenDisplay() {
+    const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+    if (extensions && strstr(extensions, "EGL_MESA_platform_surfaceless")) {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay) {
+            EGLDisplay surfaceless = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+            if (surfaceless != EGL_NO_DISPLAY) return surfaceless;
+        }
+    }
+
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+int HeadlessInit() {
+    display = OpenDisplay();
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL)) {
+        fprintf(stderr, "ERROR::HEADLESS::EGL_INIT_FAILED: 0x%x\n", eglGetError());
+        return 1;
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        fprintf(stderr, "ERROR::HEADLESS::OPENGL_API_UNAVAILABLE\n");
+        HeadlessExit();
+        return 1;
+    }
+
+    // Rendering goes to a framebuffer object, so any surface type will do
+    const EGLint configAttribs[] = {
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_SURFACE_TYPE, EGL_DONT_CARE,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_NONE
+    };
+    EGLint configCount = 0;
+    if (!eglChooseConfig(display, configAttribs, &config, 1, &configCount) || configCount == 0) {
+        fprintf(stderr, "ERROR::HEADLESS::NO_MATCHING_CONFIG\n");
+        HeadlessExit();
+        return 1;
+    }
+
+    return 0;
+}
+
+void HeadlessExit() {
+    if (display != EGL_NO_DISPLAY) eglTerminate(display);
+    display = EGL_NO_DISPLAY;
+}
+
+// ----------- Contexts -----------
+
+int HeadlessCreateContext(HeadlessContext* headless, Vector2i size, HeadlessContext* share) {
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+
+    memset(headless, 0, sizeof(HeadlessContext));
+    headless->size = size;
+    headless->display = display;
+    headless->context = eglCreateContext(display, config, share ? share->context : EGL_NO_CONTEXT, contextAttribs);
+    if (headless->context == EGL_NO_CONTEXT) {
+        fprintf(stderr, "ERROR::HEADLESS::CONTEXT_CREATION_FAILED: 0x%x\n", eglGetError());
+        return 1;
+    }
+
+    // Surfaceless contexts need EGL_KHR_surfaceless_context, which every Mesa driver has
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, headless->context)) {
+        fprintf(stderr, "ERROR::HEADLESS::MAKE_CURRENT_FAILED: 0x%x\n", eglGetError());
+        eglDestroyContext(display, headless->context);
+        headless->context = NULL;
+        return 1;
+    }
+
+    return 0;
+}
+
+void HeadlessMakeCurrent(HeadlessContext* headless) {
+    eglMakeCurrent(headless->display, EGL_NO_SURFACE, EGL_NO_SURFACE, headless->context);
+    // Without a framebuffer glad may not be loaded yet, and there is nothing to bind anyway
+    if (headless->framebuffer) glBindFramebuffer(GL_FRAMEBUFFER, headless->framebuffer);
+}
+
+void HeadlessDestroyContext(HeadlessContext* headless) {
+    if (headless->context == NULL) return;
+
+    // The names only exist once HeadlessCreateFramebuffer ran, which needs GL functions loaded
+    if (headless->framebuffer || headless->colorbuffer) {
+        HeadlessMakeCurrent(headless);
+        if (headless->framebuffer) glDeleteFramebuffers(1, &headless->framebuffer);
+        if (headless->colorbuffer) glDeleteRenderbuffers(1, &headless->colorbuffer);
+        headless->framebuffer = 0;
+        headless->colorbuffer = 0;
+    }
+
+    eglMakeCurrent(headless->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(headless->display, headless->context);
+    headless->context = NULL;
+}
+
+void* HeadlessGetProcAddress(const char* name) {
+    return (void*)eglGetProcAddress(name);
+}
+
+#else
+
+int HeadlessInit() {
+    fprintf(stderr, "ERROR::HEADLESS::NOT_BUILT: rebuild with make HEADLESS=1\n");
+    return 1;
+}
+
+void HeadlessExit() {}
+
+int HeadlessCreateContext(HeadlessContext* headless, Vector2i size, HeadlessContext* share) {
+    (void)size;
+    (void)share;
+    memset(headless, 0, sizeof(HeadlessContext));
+    return 1;
+}
+
+void HeadlessMakeCurrent(HeadlessContext* headless) {
+    (void)headless;
+}
+
+void HeadlessDestroyContext(HeadlessContext* headless) {
+    (void)headless;
+}
+
+void* HeadlessGetProcAddress(const char* name) {
+    (void)name;
+    return NULL;
+}
+
+#endif
+
+// ----------- Framebuffer -----------
+
+int HeadlessCreateFramebuffer(HeadlessContext* headless) {
+    glGenRenderbuffers(1, &headless->colorbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, headless->colorbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, headless->size.x, headless->size.y);
+
+    glGenFramebuffers(1, &headless->framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, headless->framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, headless->colorbuffer);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        fprintf(stderr, "ERROR::HEADLESS::FRAMEBUFFER_INCOMPLETE\n");
+        return 1;
+    }
+
+    glViewport(0, 0, headless->size.x, headless->size.y);
+    return 0;
+}
+
+void HeadlessResizeFramebuffer(HeadlessContext* headless, Vector2i size) {
+    headless->size = size;
+    glBindRenderbuffer(GL_RENDERBUFFER, headless->colorbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size.x, size.y);
+    glViewport(0, 0, size.x, size.y);
+}
+
+int HeadlessReadPixels(HeadlessContext* headless, uint8_t* pixels) {
+    size_t rowSize = (size_t)headless->size.x * 4;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, headless->framebuffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, headless->size.x, headless->size.y, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+    // GL hands rows back bottom up
+    uint8_t* row = malloc(rowSize);
+    if (row == NULL) return 1;
+
+    for (int top = 0, bottom = headless->size.y - 1; top < bottom; top++, bottom--) {
+        memcpy(row, pixels + top * rowSize, rowSize);
+        memcpy(pixels + top * rowSize, pixels + bottom * rowSize, rowSize);
+        memcpy(pixels + bottom * rowSize, row, rowSize);
+    }
+
+    free(row);
+    return 0;
+}
@@ -0,0 +1,37 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <stdint.h>
+
+#include "types.h"
+
+// An offscreen OpenGL context that renders into a framebuffer object instead of a window.
+// Only available when built with GUILAY_HEADLESS (make HEADLESS=1), otherwise every call fails.
+typedef struct HeadlessContext {
+    void* display;
+    void* context;
+    unsigned int framebuffer;
+    unsigned int colorbuffer;
+    Vector2i size;
+} HeadlessContext;
+
+// Connects to EGL, prefers the surfaceless platform so no X server or GPU is needed
+int HeadlessInit();
+void HeadlessExit();
+
+// Creates a GL 3.3 core context sharing objects with share when it is not NULL,
+// use HeadlessCreateFramebuffer once GL functions are loaded
+int HeadlessCreateContext(HeadlessContext* headless, Vector2i size, HeadlessContext* share);
+int HeadlessCreateFramebuffer(HeadlessContext* headless);
+// Reallocates the color buffer, the context has to be current
+void HeadlessResizeFramebuffer(HeadlessContext* headless, Vector2i size);
+void HeadlessMakeCurrent(HeadlessContext* headless);
+void HeadlessDestroyContext(HeadlessContext* headless);
+
+// Loader for glad
+void* HeadlessGetProcAddress(const char* name);
+
+// Reads the framebuffer as tightly packed RGBA rows, top row first
+int HeadlessReadPixels(HeadlessContext* headless, uint8_t* pixels);
+
+#endif
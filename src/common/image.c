@@ -0,0 +1,194 @@
+#include "image.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Refuses anything bigger, a corrupt header should not be able to ask for gigabytes
+#define IMAGE_MAX_SIDE 16384
+
+static uint8_t* ReadFile(const char* path, size_t* size) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) return NULL;
+
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (length <= 0) {
+        fclose(file);
+        return NULL;
+    }
+
+    uint8_t* data = malloc((size_t)length);
+    if (data && fread(data, 1, (size_t)length, file) != (size_t)length) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+
+    *size = (size_t)length;
+    return data;
+}
+
+static int AllocatePixels(DecodedImage* image, int width, int height) {
+    if (width <= 0 || height <= 0 || width > IMAGE_MAX_SIDE || height > IMAGE_MAX_SIDE) return 1;
+
+    image->pixels = malloc((size_t)width * height * 4);
+    if (image->pixels == NULL) return 1;
+    image->width = width;
+    image->height = height;
+    return 0;
+}
+
+// ----------- TGA -----------
+
+static void ReadTgaPixel(const uint8_t* src, int bytesPerPixel, uint8_t* rgba) {
+    if (bytesPerPixel == 1) {
+        rgba[0] = rgba[1] = rgba[2] = src[0];
+        rgba[3] = 255;
+    } else {
+        // Stored as BGR(A)
+        rgba[0] = src[2];
+        rgba[1] = src[1];
+        rgba[2] = src[0];
+        rgba[3] = bytesPerPixel == 4 ? src[3] : 255;
+    }
+}
+
+static int DecodeTga(const uint8_t* data, size_t size, DecodedImage* image) {
+    if (size < 18) return 1;
+
+    int idLength = data[0];
+    int colorMapType = data[1];
+    int type = data[2];
+    int width = data[12] | data[13] << 8;
+    int height = data[14] | data[15] << 8;
+    int bitsPerPixel = data[16];
+    int topDown = data[17] & 0x20;
+
+    int rle = type == 10 || type == 11;
+    int gray = type == 3 || type == 11;
+    if (colorMapType != 0 || !(type == 2 || type == 3 || type == 10 || type == 11)) {
+        fprintf(stderr, "ERROR::IMAGE::TGA_TYPE_UNSUPPORTED: %d\n", type);
+        return 1;
+    }
+    if (gray ? bitsPerPixel != 8 : bitsPerPixel != 24 && bitsPerPixel != 32) {
+        fprintf(stderr, "ERROR::IMAGE::TGA_DEPTH_UNSUPPORTED: %d\n", bitsPerPixel);
+        return 1;
+    }
+    if (AllocatePixels(image, width, height)) return 1;
+
+    int bytesPerPixel = bitsPerPixel / 8;
+    const uint8_t* src = data + 18 + idLength;
+    const uint8_t* end = data + size;
+    size_t pixelCount = (size_t)width * height;
+
+    for (size_t i = 0; i < pixelCount;) {
+        size_t run = 1;
+        int repeat = 0;
+        if (rle) {
+            if (src >= end) goto truncated;
+            repeat = *src & 0x80;
+            run = (size_t)(*src & 0x7f) + 1;
+            src++;
+        }
+        if (run > pixelCount - i) run = pixelCount - i;
+
+        for (size_t j = 0; j < run; j++, i++) {
+            if (src + bytesPerPixel > end) goto truncated;
+            // Rows are flipped while writing so pixels always come out top row first
+            size_t x = i % width, y = i / width;
+            size_t row = topDown ? y : (size_t)height - 1 - y;
+            ReadTgaPixel(src, bytesPerPixel, image->pixels + (row * width + x) * 4);
+            if (!repeat) src += bytesPerPixel;
+        }
+        if (repeat) src += bytesPerPixel;
+    }
+    return 0;
+
+truncated:
+    fprintf(stderr, "ERROR::IMAGE::TGA_TRUNCATED\n");
+    FreeDecodedImage(image);
+    return 1;
+}
+
+// ----------- PPM -----------
+
+// Reads a header number, skipping whitespace and comments
+static int ReadPnmNumber(const uint8_t** src, const uint8_t* end, int* value) {
+    while (*src < end && (isspace(**src) || **src == '#')) {
+        if (**src == '#') while (*src < end && **src != '\n') (*src)++;
+        else (*src)++;
+    }
+    if (*src >= end || !isdigit(**src)) return 1;
+
+    *value = 0;
+    while (*src < end && isdigit(**src)) {
+        if (*value > IMAGE_MAX_SIDE * 16) return 1;
+        *value = *value * 10 + (**src - '0');
+        (*src)++;
+    }
+    return 0;
+}
+
+static int DecodePnm(const uint8_t* data, size_t size, DecodedImage* image) {
+    int channels = data[1] == '6' ? 3 : 1;
+    const uint8_t* src = data + 2;
+    const uint8_t* end = data + size;
+
+    // The header ends with a single whitespace, a file that stops right after maxval has no pixels at all
+    int width, height, maxValue;
+    if (ReadPnmNumber(&src, end, &width) || ReadPnmNumber(&src, end, &height) ||
+        ReadPnmNumber(&src, end, &maxValue) || maxValue <= 0 || maxValue > 255 ||
+        src >= end || !isspace(*src)) {
+        fprintf(stderr, "ERROR::IMAGE::PNM_HEADER_INVALID\n");
+        return 1;
+    }
+    src++;
+
+    if (AllocatePixels(image, width, height)) return 1;
+    size_t pixelCount = (size_t)width * height;
+    if ((size_t)(end - src) < pixelCount * channels) {
+        fprintf(stderr, "ERROR::IMAGE::PNM_TRUNCATED\n");
+        FreeDecodedImage(image);
+        return 1;
+    }
+
+    for (size_t i = 0; i < pixelCount; i++, src += channels) {
+        uint8_t* rgba = image->pixels + i * 4;
+        for (int c = 0; c < 3; c++) rgba[c] = (uint8_t)(src[channels == 3 ? c : 0] * 255 / maxValue);
+        rgba[3] = 255;
+    }
+    return 0;
+}
+
+// ----------- Decoding -----------
+
+int DecodeImage(const char* path, DecodedImage* image) {
+    memset(image, 0, sizeof(DecodedImage));
+
+    size_t size = 0;
+    uint8_t* data = ReadFile(path, &size);
+    if (data == NULL) {
+        fprintf(stderr, "ERROR::IMAGE::FILE_NOT_READ: %s\n", path);
+        return 1;
+    }
+
+    int result;
+    if (size >= 2 && data[0] == 'P' && (data[1] == '5' || data[1] == '6')) {
+        result = DecodePnm(data, size, image);
+    } else {
+        // TGA has no magic number, its header is checked instead
+        result = DecodeTga(data, size, image);
+    }
+
+    free(data);
+    if (result) fprintf(stderr, "ERROR::IMAGE::DECODE_FAILED: %s\n", path);
+    return result;
+}
+
+void FreeDecodedImage(DecodedImage* image) {
+    free(image->pixels);
+    memset(image, 0, sizeof(DecodedImage));
+}
@@ -0,0 +1,18 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <stdint.h>
+
+// Tightly packed RGBA pixels, top row first
+typedef struct DecodedImage {
+    int width;
+    int height;
+    uint8_t* pixels;
+} DecodedImage;
+
+// Decodes TGA (uncompressed or RLE, 8/24/32 bit) and binary PPM/PGM (P6/P5) files.
+// Safe to call from any thread, returns 1 and leaves image empty on failure.
+int DecodeImage(const char* path, DecodedImage* image);
+void FreeDecodedImage(DecodedImage* image);
+
+#endif
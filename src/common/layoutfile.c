@@ -0,0 +1,431 @@
+#include "layoutfile.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "elements.h"
+#include "stringtable.h"
+
+// Deeper files are rejected, checking and compiling them recurse once per level
+#define LAYOUT_MAX_DEPTH 256
+
+// ----------- Reading -----------
+
+const LayoutHeader* GetLayoutHeader(const LayoutMapping* mapping) {
+    return (const LayoutHeader*)mapping->data;
+}
+
+const LayoutRecord* GetLayoutRecords(const LayoutMapping* mapping) {
+    return (const LayoutRecord*)(mapping->data + sizeof(LayoutHeader));
+}
+
+const char* GetLayoutStrings(const LayoutMapping* mapping) {
+    return (const char*)mapping->data + GetLayoutHeader(mapping)->stringsOffset;
+}
+
+// Checks that the siblings in [first, end) and everything inside of them nest properly, returns their count
+static int CheckSiblings(const LayoutMapping* mapping, uint32_t first, uint32_t end, int depth, uint32_t* count) {
+    const LayoutHeader* header = GetLayoutHeader(mapping);
+    const LayoutRecord* records = GetLayoutRecords(mapping);
+    const char* strings = GetLayoutStrings(mapping);
+    if (depth > LAYOUT_MAX_DEPTH) return 1;
+
+    *count = 0;
+    for (uint32_t i = first; i < end; i = records[i].end) {
+        const LayoutRecord* record = &records[i];
+        if (record->type > IMAGE || record->end <= i || record->end > end) return 1;
+        if (record->type != SECTION && record->end != i + 1) return 1;
+        if ((uint64_t)record->text + record->length >= header->stringsSize || strings[record->text + record->length]) return 1;
+
+        uint32_t children;
+        if (record->end > i + 1 && CheckSiblings(mapping, i + 1, record->end, depth + 1, &children)) return 1;
+        (*count)++;
+    }
+    return 0;
+}
+
+static int CheckLayout(const LayoutMapping* mapping) {
+    if (mapping->size < sizeof(LayoutHeader)) return 1;
+
+    const LayoutHeader* header = GetLayoutHeader(mapping);
+    if (header->magic != LAYOUT_MAGIC || header->version != LAYOUT_VERSION) return 1;
+
+    uint64_t recordsEnd = sizeof(LayoutHeader) + (uint64_t)header->elementCount * sizeof(LayoutRecord);
+    if (recordsEnd > mapping->size || header->stringsOffset < recordsEnd) return 1;
+    if ((uint64_t)header->stringsOffset + header->stringsSize > mapping->size) return 1;
+
+    uint32_t roots;
+    if (CheckSiblings(mapping, 0, header->elementCount, 0, &roots)) return 1;
+    return roots != header->rootCount;
+}
+
+int MapLayout(LayoutMapping* mapping, const char* path) {
+    memset(mapping, 0, sizeof(LayoutMapping));
+
+#ifdef _WIN32
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "ERROR::LAYOUT::FILE_NOT_READ: %s\n", path);
+        return 1;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t* data = size > 0 ? malloc((size_t)size) : NULL;
+    if (data == NULL || fread(data, 1, (size_t)size, file) != (size_t)size) {
+        fprintf(stderr, "ERROR::LAYOUT::FILE_NOT_READ: %s\n", path);
+        free(data);
+        fclose(file);
+        return 1;
+    }
+    fclose(file);
+    mapping->data = data;
+    mapping->size = (size_t)size;
+#else
+    int file = open(path, O_RDONLY);
+    struct stat info;
+    if (file < 0 || fstat(file, &info) != 0 || info.st_size <= 0) {
+        fprintf(stderr, "ERROR::LAYOUT::FILE_NOT_READ: %s\n", path);
+        if (file >= 0) close(file);
+        return 1;
+    }
+
+    // Pages are only read in as the records are touched, nothing is copied
+    void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "ERROR::LAYOUT::FILE_NOT_MAPPED: %s\n", path);
+        return 1;
+    }
+    mapping->data = data;
+    mapping->size = (size_t)info.st_size;
+    mapping->mapped = true;
+#endif
+
+    if (CheckLayout(mapping)) {
+        fprintf(stderr, "ERROR::LAYOUT::INVALID_FILE: %s\n", path);
+        UnmapLayout(mapping);
+        return 1;
+    }
+    return 0;
+}
+
+void UnmapLayout(LayoutMapping* mapping) {
+#ifndef _WIN32
+    if (mapping->mapped) munmap((void*)mapping->data, mapping->size);
+    else
+#endif
+    free((void*)mapping->data);
+    memset(mapping, 0, sizeof(LayoutMapping));
+}
+
+// ----------- Compiling -----------
+
+typedef struct LayoutCompiler {
+    const char* source; // Path, for errors
+    const char* cursor;
+    int line;
+
+    LayoutRecord* records;
+    size_t count;
+    size_t capacity;
+    uint32_t roots;
+
+    StringTable strings;  // Every distinct string is stored once
+    uint32_t* offsets;    // Offset in the strings block by string id - 1
+    size_t offsetCapacity;
+    char* block;          // The strings block being written
+    size_t blockSize;
+    size_t blockCapacity;
+    uint32_t stored;      // Strings already in the block
+
+    char* scratch;        // The string being read
+    size_t scratchSize;
+    size_t scratchCapacity;
+} LayoutCompiler;
+
+static int CompileError(LayoutCompiler* compiler, const char* message) {
+    fprintf(stderr, "%s:%d: %s\n", compiler->source, compiler->line, message);
+    return 1;
+}
+
+static void SkipSpace(LayoutCompiler* compiler) {
+    for (;;) {
+        char c = *compiler->cursor;
+        if (c == '\n') compiler->line++;
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') compiler->cursor++;
+        else if (c == '/' && compiler->cursor[1] == '/') {
+            while (*compiler->cursor && *compiler->cursor != '\n') compiler->cursor++;
+        } else return;
+    }
+}
+
+// Reads a word made of letters, returns its length
+static size_t ReadWord(LayoutCompiler* compiler, const char** word) {
+    *word = compiler->cursor;
+    while (isalpha((unsigned char)*compiler->cursor)) compiler->cursor++;
+    return (size_t)(compiler->cursor - *word);
+}
+
+static bool IsWord(const char* word, size_t length, const char* expected) {
+    return strlen(expected) == length && strncmp(word, expected, length) == 0;
+}
+
+// Properties are words followed by =, any other word starts the next element
+static bool AtProperty(const LayoutCompiler* compiler) {
+    const char* c = compiler->cursor;
+    while (isalpha((unsigned char)*c)) c++;
+    return c > compiler->cursor && *c == '=';
+}
+
+static int ReadFloats(LayoutCompiler* compiler, float* values, int count) {
+    for (int i = 0; i < count; i++) {
+        if (i > 0 && *compiler->cursor++ != ',') return CompileError(compiler, "expected two numbers like 10,20");
+        char* end;
+        values[i] = strtof(compiler->cursor, &end);
+        if (end == compiler->cursor) return CompileError(compiler, "expected a number");
+        compiler->cursor = end;
+    }
+    return 0;
+}
+
+static int ReadColor(LayoutCompiler* compiler, uint8_t* color) {
+    if (*compiler->cursor++ != '#') return CompileError(compiler, "expected a color like #rrggbb or #rrggbbaa");
+
+    const char* start = compiler->cursor;
+    while (isxdigit((unsigned char)*compiler->cursor)) compiler->cursor++;
+    size_t digits = (size_t)(compiler->cursor - start);
+    if (digits != 6 && digits != 8) return CompileError(compiler, "expected a color like #rrggbb or #rrggbbaa");
+
+    color[3] = 255;
+    for (size_t i = 0; i < digits / 2; i++) {
+        char pair[3] = {start[i * 2], start[i * 2 + 1], '\0'};
+        color[i] = (uint8_t)strtoul(pair, NULL, 16);
+    }
+    return 0;
+}
+
+static int Reserve(void** array, size_t* capacity, size_t needed, size_t itemSize) {
+    if (needed <= *capacity) return 0;
+
+    size_t grown = *capacity ? *capacity : 256;
+    while (grown < needed) grown *= 2;
+    void* items = realloc(*array, grown * itemSize);
+    if (items == NULL) return 1;
+    *array = items;
+    *capacity = grown;
+    return 0;
+}
+
+// Adds a string to the block unless the same one is already there
+static int AddString(LayoutCompiler* compiler, StringView string, uint32_t* offset) {
+    StringId id = StringTableIntern(&compiler->strings, string);
+    if (id == 0) return CompileError(compiler, "out of memory");
+
+    // Ids are handed out in order, so a string seen for the first time gets the next one
+    if (id > compiler->stored) {
+        if (compiler->blockSize + string.length + 1 > UINT32_MAX) return CompileError(compiler, "too many strings");
+        if (Reserve((void**)&compiler->offsets, &compiler->offsetCapacity, id, sizeof(uint32_t)) ||
+            Reserve((void**)&compiler->block, &compiler->blockCapacity, compiler->blockSize + string.length + 1, 1)) {
+            return CompileError(compiler, "out of memory");
+        }
+
+        compiler->offsets[id - 1] = (uint32_t)compiler->blockSize;
+        if (string.length) memcpy(compiler->block + compiler->blockSize, string.data, string.length);
+        compiler->block[compiler->blockSize + string.length] = '\0';
+        compiler->blockSize += string.length + 1;
+        compiler->stored = id;
+    }
+
+    *offset = compiler->offsets[id - 1];
+    return 0;
+}
+
+// Reads a quoted string with \" \\ and \n escapes into the scratch buffer
+static int ReadString(LayoutCompiler* compiler, StringView* string) {
+    compiler->cursor++;
+    compiler->scratchSize = 0;
+
+    for (;;) {
+        char c = *compiler->cursor++;
+        if (c == '\0' || c == '\n') return CompileError(compiler, "unterminated string");
+        if (c == '"') break;
+        if (c == '\\') {
+            c = *compiler->cursor++;
+            if (c == 'n') c = '\n';
+            else if (c != '"' && c != '\\') return CompileError(compiler, "unknown escape, use \\\", \\\\ or \\n");
+        }
+
+        if (Reserve((void**)&compiler->scratch, &compiler->scratchCapacity, compiler->scratchSize + 1, 1)) {
+            return CompileError(compiler, "out of memory");
+        }
+        compiler->scratch[compiler->scratchSize++] = c;
+    }
+
+    *string = (StringView){compiler->scratch, compiler->scratchSize};
+    return 0;
+}
+
+static int ReadProperty(LayoutCompiler* compiler, LayoutRecord* record) {
+    const char* name;
+    size_t length = ReadWord(compiler, &name);
+    if (*compiler->cursor++ != '=') return CompileError(compiler, "expected = after the property name");
+
+    uint8_t type = record->type;
+    if (IsWord(name, length, "size")) return ReadFloats(compiler, record->size, 2);
+    if (IsWord(name, length, "scroll") && type == SECTION) return ReadFloats(compiler, record->scroll, 2);
+    if (IsWord(name, length, "scale") && (type == TEXT || type == BUTTON)) return ReadFloats(compiler, &record->scale, 1);
+    if (IsWord(name, length, "color") && type != IMAGE) return ReadColor(compiler, record->color);
+    if (IsWord(name, length, "tint") && type == IMAGE) return ReadColor(compiler, record->color);
+    if (IsWord(name, length, "label") && type == BUTTON) return ReadColor(compiler, record->labelColor);
+    return CompileError(compiler, "unknown property for this kind of element");
+}
+
+// Compiles elements until the end of the source, or the } closing the section they are in
+static int CompileElements(LayoutCompiler* compiler, int depth, uint32_t* siblings) {
+    if (depth > LAYOUT_MAX_DEPTH) return CompileError(compiler, "sections nested too deep");
+
+    for (;;) {
+        SkipSpace(compiler);
+        char c = *compiler->cursor;
+        if (c == '\0') return depth > 0 ? CompileError(compiler, "missing }") : 0;
+        if (c == '}') {
+            if (depth == 0) return CompileError(compiler, "} without a section");
+            compiler->cursor++;
+            return 0;
+        }
+
+        const char* word;
+        size_t length = ReadWord(compiler, &word);
+        ElementType type;
+        if (IsWord(word, length, "text")) type = TEXT;
+        else if (IsWord(word, length, "section")) type = SECTION;
+        else if (IsWord(word, length, "button")) type = BUTTON;
+        else if (IsWord(word, length, "image")) type = IMAGE;
+        else return CompileError(compiler, "expected text, section, button or image");
+
+        if (compiler->count >= UINT32_MAX - 1 ||
+            Reserve((void**)&compiler->records, &compiler->capacity, compiler->count + 1, sizeof(LayoutRecord))) {
+            return CompileError(compiler, "too many elements");
+        }
+        // Records move while the arrays grow, so they are only reached by index
+        size_t index = compiler->count++;
+        LayoutRecord* record = &compiler->records[index];
+        memset(record, 0, sizeof(LayoutRecord));
+        record->type = (uint8_t)type;
+        record->end = (uint32_t)compiler->count;
+        if (type != SECTION) {
+            memset(record->color, 255, 4);
+            memset(record->labelColor, 255, 4);
+            record->scale = 1;
+        }
+
+        bool hasString = false;
+        for (;;) {
+            SkipSpace(compiler);
+            c = *compiler->cursor;
+            if (AtProperty(compiler)) {
+                if (ReadProperty(compiler, &compiler->records[index])) return 1;
+            } else if (c == '"' && type != SECTION && !hasString) {
+                StringView string;
+                if (ReadString(compiler, &string) || AddString(compiler, string, &compiler->records[index].text)) return 1;
+                compiler->records[index].length = (uint32_t)string.length;
+                hasString = true;
+            } else break;
+        }
+        if (type == IMAGE && !hasString) return CompileError(compiler, "image without a path");
+
+        if (type == SECTION && *compiler->cursor == '{') {
+            compiler->cursor++;
+            uint32_t children = 0;
+            if (CompileElements(compiler, depth + 1, &children)) return 1;
+            compiler->records[index].end = (uint32_t)compiler->count;
+        }
+        (*siblings)++;
+    }
+}
+
+static char* ReadSource(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) return NULL;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* text = size >= 0 ? malloc((size_t)size + 1) : NULL;
+    if (text && fread(text, 1, (size_t)size, file) != (size_t)size) {
+        free(text);
+        text = NULL;
+    }
+    if (text) text[size] = '\0';
+    fclose(file);
+    return text;
+}
+
+static int WriteLayout(LayoutCompiler* compiler, const char* destination) {
+    LayoutHeader header = {
+        .magic = LAYOUT_MAGIC,
+        .version = LAYOUT_VERSION,
+        .elementCount = (uint32_t)compiler->count,
+        .rootCount = compiler->roots,
+        .stringsOffset = (uint32_t)(sizeof(LayoutHeader) + compiler->count * sizeof(LayoutRecord)),
+        .stringsSize = (uint32_t)compiler->blockSize
+    };
+    if ((uint64_t)header.stringsOffset + header.stringsSize > UINT32_MAX) {
+        fprintf(stderr, "%s: layout too big\n", compiler->source);
+        return 1;
+    }
+
+    FILE* file = fopen(destination, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "%s: could not write\n", destination);
+        return 1;
+    }
+    int failed = fwrite(&header, sizeof(header), 1, file) != 1 ||
+                 (compiler->count && fwrite(compiler->records, sizeof(LayoutRecord), compiler->count, file) != compiler->count) ||
+                 fwrite(compiler->block, 1, compiler->blockSize, file) != compiler->blockSize;
+    failed |= fclose(file) != 0;
+    if (failed) {
+        fprintf(stderr, "%s: could not write\n", destination);
+        remove(destination);
+    }
+    return failed;
+}
+
+int CompileLayout(const char* source, const char* destination) {
+    LayoutCompiler compiler;
+    memset(&compiler, 0, sizeof(LayoutCompiler));
+    compiler.source = source;
+    compiler.line = 1;
+    InitStringTable(&compiler.strings);
+
+    char* text = ReadSource(source);
+    if (text == NULL) {
+        fprintf(stderr, "%s: could not read\n", source);
+        return 1;
+    }
+    compiler.cursor = text;
+
+    // Elements without a string point at the empty one at offset 0
+    uint32_t empty;
+    int failed = AddString(&compiler, (StringView){"", 0}, &empty) ||
+                 CompileElements(&compiler, 0, &compiler.roots) ||
+                 WriteLayout(&compiler, destination);
+
+    free(text);
+    free(compiler.records);
+    free(compiler.offsets);
+    free(compiler.block);
+    free(compiler.scratch);
+    FreeStringTable(&compiler.strings);
+    return failed;
+}
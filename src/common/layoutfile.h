@@ -0,0 +1,63 @@
+#ifndef LAYOUTFILE_H
+#define LAYOUTFILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// "GLAY" read as a little endian number, files are written in the byte order of the machine compiling them
+#define LAYOUT_MAGIC 0x59414C47u
+#define LAYOUT_VERSION 1
+
+// A compiled layout is this header, elementCount records in pre-order and a block of 0 terminated strings
+typedef struct LayoutHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t elementCount;
+    uint32_t rootCount;     // Elements at the top level
+    uint32_t stringsOffset; // From the start of the file
+    uint32_t stringsSize;
+} LayoutHeader;
+
+typedef struct LayoutRecord {
+    uint8_t type; // ElementType
+    uint8_t reserved[3];
+    uint32_t end; // One past the last element inside of it
+    float size[2];
+    float scroll[2];       // Sections
+    uint8_t color[4];      // Red, green, blue and alpha of section and button fills, text colors and image tints
+    uint8_t labelColor[4]; // Buttons
+    float scale;           // Texts and button labels
+    uint32_t text;         // Offset of the text, label or image path in the strings, 0 terminated
+    uint32_t length;
+} LayoutRecord;
+
+// A compiled layout mapped into memory, or read into one buffer where mapping is not available
+typedef struct LayoutMapping {
+    const uint8_t* data;
+    size_t size;
+    bool mapped;
+} LayoutMapping;
+
+// Maps the file and checks every offset in it once, so the records can be used without any further checks.
+// Returns 1 when the file can not be read or is not a valid layout.
+int MapLayout(LayoutMapping* mapping, const char* path);
+void UnmapLayout(LayoutMapping* mapping);
+
+const LayoutHeader* GetLayoutHeader(const LayoutMapping* mapping);
+const LayoutRecord* GetLayoutRecords(const LayoutMapping* mapping);
+const char* GetLayoutStrings(const LayoutMapping* mapping);
+
+// Compiles the human readable description at source into a layout file at destination, errors go to stderr.
+//
+//     // Comments run to the end of the line
+//     section size=300,400 color=#1e1e3c scroll=0,0 {
+//         text size=280,18 scale=0.4 color=#ffffff "Hello"
+//         button size=200,24 color=#3c78c8 scale=0.4 label=#ffffff "Press"
+//         image size=16,16 tint=#ffffffff "icons/open.tga"
+//     }
+//
+// Colors are #rrggbb or #rrggbbaa. Texts, labels and tints are white by default and scales 1, the rest is 0.
+int CompileLayout(const char* source, const char* destination);
+
+#endif
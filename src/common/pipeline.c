@@ -0,0 +1,109 @@
+#include "pipeline.h"
+
+#include <stdio.h>
+
+static void* PipelineWorker(void* argument) {
+    FramePipeline* pipeline = argument;
+
+    pthread_mutex_lock(&pipeline->lock);
+    for (;;) {
+        while (!pipeline->quit && !(pipeline->pending && !pipeline->built)) {
+            pthread_cond_wait(&pipeline->wake, &pipeline->lock);
+        }
+        if (pipeline->quit) break;
+
+        // The back packet is only ever touched by this thread until built is set
+        DrawList* back = &pipeline->packets[1 - pipeline->front];
+        pthread_mutex_unlock(&pipeline->lock);
+
+        ClearDrawList(back);
+        pipeline->build(back, pipeline->user);
+
+        pthread_mutex_lock(&pipeline->lock);
+        pipeline->built = true;
+        pthread_cond_broadcast(&pipeline->wake);
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+
+    return NULL;
+}
+
+int StartFramePipeline(FramePipeline* pipeline, FrameBuildFunction build, void* user) {
+    InitDrawList(&pipeline->packets[0]);
+    InitDrawList(&pipeline->packets[1]);
+    pipeline->front = 0;
+    pipeline->pending = false;
+    pipeline->built = false;
+    pipeline->quit = false;
+    pipeline->build = build;
+    pipeline->user = user;
+
+    pthread_mutex_init(&pipeline->lock, NULL);
+    pthread_cond_init(&pipeline->wake, NULL);
+
+    pipeline->threaded = pthread_create(&pipeline->worker, NULL, PipelineWorker, pipeline) == 0;
+    if (!pipeline->threaded) {
+        fprintf(stderr, "Warning: Could not start the frame worker, frames are built on the calling thread.\n");
+    }
+    return 0;
+}
+
+void StopFramePipeline(FramePipeline* pipeline) {
+    if (pipeline->threaded) {
+        pthread_mutex_lock(&pipeline->lock);
+        pipeline->quit = true;
+        pthread_cond_broadcast(&pipeline->wake);
+        pthread_mutex_unlock(&pipeline->lock);
+
+        pthread_join(pipeline->worker, NULL);
+    }
+
+    pthread_cond_destroy(&pipeline->wake);
+    pthread_mutex_destroy(&pipeline->lock);
+    FreeDrawList(&pipeline->packets[0]);
+    FreeDrawList(&pipeline->packets[1]);
+}
+
+void RequestFrame(FramePipeline* pipeline) {
+    pthread_mutex_lock(&pipeline->lock);
+    if (!pipeline->pending) {
+        pipeline->pending = true;
+        pipeline->built = false;
+        pthread_cond_broadcast(&pipeline->wake);
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+}
+
+DrawList* CollectFrame(FramePipeline* pipeline) {
+    RequestFrame(pipeline);
+
+    if (!pipeline->threaded) {
+        DrawList* back = &pipeline->packets[1 - pipeline->front];
+        ClearDrawList(back);
+        pipeline->build(back, pipeline->user);
+        pipeline->built = true;
+    }
+
+    pthread_mutex_lock(&pipeline->lock);
+    while (!pipeline->built) {
+        pthread_cond_wait(&pipeline->wake, &pipeline->lock);
+    }
+
+    pipeline->front = 1 - pipeline->front;
+    pipeline->pending = false;
+    pipeline->built = false;
+    pthread_mutex_unlock(&pipeline->lock);
+
+    return &pipeline->packets[pipeline->front];
+}
+
+void DiscardFrame(FramePipeline* pipeline) {
+    pthread_mutex_lock(&pipeline->lock);
+    while (pipeline->threaded && pipeline->pending && !pipeline->built) {
+        pthread_cond_wait(&pipeline->wake, &pipeline->lock);
+    }
+
+    pipeline->pending = false;
+    pipeline->built = false;
+    pthread_mutex_unlock(&pipeline->lock);
+}
@@ -0,0 +1,40 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+
+#include "drawlist.h"
+
+// Fills a packet with the draw commands of a frame, runs on the worker thread
+typedef void (*FrameBuildFunction)(DrawList* packet, void* user);
+
+// Builds frame packets on a worker thread while the previous packet is submitted.
+// Two packets are kept, the front one belongs to the submitting thread and the back one to the worker.
+typedef struct FramePipeline {
+    DrawList packets[2];
+    int front;
+    bool pending; // A build was requested and not collected yet
+    bool built;   // The requested build has finished
+    bool quit;
+    bool threaded; // False when the worker could not be started, builds then happen in CollectFrame
+
+    FrameBuildFunction build;
+    void* user;
+
+    pthread_t worker;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+} FramePipeline;
+
+int StartFramePipeline(FramePipeline* pipeline, FrameBuildFunction build, void* user);
+void StopFramePipeline(FramePipeline* pipeline);
+
+// Starts building the next packet if no build is pending
+void RequestFrame(FramePipeline* pipeline);
+// Waits for the pending packet, requesting one first if needed, and makes it the front packet
+DrawList* CollectFrame(FramePipeline* pipeline);
+// Drops a build that was requested before the state it depends on changed, waiting for it if it is running
+void DiscardFrame(FramePipeline* pipeline);
+
+#endif
@@ -0,0 +1,380 @@
+#include "quadtree.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Root growth stops after this many doublings, items still outside then just live in the root
+#define QUADTREE_MAX_GROWTH 32
+
+// ----------- Pool -----------
+
+static void PoolInit(QuadtreePool* pool, size_t slotSize) {
+    memset(pool, 0, sizeof(QuadtreePool));
+    // Free slots store the next free slot in their first bytes
+    pool->slotSize = slotSize < sizeof(void*) ? sizeof(void*) : slotSize;
+    pool->used = QUADTREE_POOL_BLOCK;
+}
+
+static void* PoolAlloc(QuadtreePool* pool) {
+    if (pool->free) {
+        void* slot = pool->free;
+        memcpy(&pool->free, slot, sizeof(void*));
+        return slot;
+    }
+
+    if (pool->used == QUADTREE_POOL_BLOCK) {
+        void** blocks = realloc(pool->blocks, (pool->blockCount + 1) * sizeof(void*));
+        if (blocks == NULL) return NULL;
+        pool->blocks = blocks;
+
+        void* block = malloc(pool->slotSize * QUADTREE_POOL_BLOCK);
+        if (block == NULL) return NULL;
+        pool->blocks[pool->blockCount++] = block;
+        pool->used = 0;
+    }
+
+    return (char*)pool->blocks[pool->blockCount - 1] + pool->slotSize * pool->used++;
+}
+
+static void PoolFree(QuadtreePool* pool, void* slot) {
+    memcpy(slot, &pool->free, sizeof(void*));
+    pool->free = slot;
+}
+
+static void PoolDestroy(QuadtreePool* pool) {
+    for (size_t i = 0; i < pool->blockCount; i++) free(pool->blocks[i]);
+    free(pool->blocks);
+    memset(pool, 0, sizeof(QuadtreePool));
+}
+
+// ----------- Helpers -----------
+
+static int RectContains(Rect outer, Rect inner) {
+    return inner.position.x >= outer.position.x && inner.position.y >= outer.position.y &&
+           inner.position.x + inner.size.x <= outer.position.x + outer.size.x &&
+           inner.position.y + inner.size.y <= outer.position.y + outer.size.y;
+}
+
+static int RectsOverlap(Rect a, Rect b) {
+    return a.position.x < b.position.x + b.size.x && b.position.x < a.position.x + a.size.x &&
+           a.position.y < b.position.y + b.size.y && b.position.y < a.position.y + a.size.y;
+}
+
+static int RectContainsPoint(Rect rect, Vector2 point) {
+    return point.x >= rect.position.x && point.x < rect.position.x + rect.size.x &&
+           point.y >= rect.position.y && point.y < rect.position.y + rect.size.y;
+}
+
+static Rect Quadrant(Rect bounds, int index) {
+    Vector2 half = {bounds.size.x * 0.5f, bounds.size.y * 0.5f};
+    return (Rect){{bounds.position.x + (index & 1) * half.x, bounds.position.y + (index >> 1) * half.y}, half};
+}
+
+static QuadtreeNode* NewNode(Quadtree* tree, Rect bounds, QuadtreeNode* parent) {
+    QuadtreeNode* node = PoolAlloc(&tree->nodes);
+    if (node == NULL) {
+        fprintf(stderr, "Error: Quadtree node allocation failed.\n");
+        return NULL;
+    }
+
+    memset(node, 0, sizeof(QuadtreeNode));
+    node->bounds = bounds;
+    node->status = QT_EMPTY;
+    node->parent = parent;
+    return node;
+}
+
+static void UpdateStatus(QuadtreeNode* node) {
+    if (node->subtreeCount == 0) node->status = QT_EMPTY;
+    else if (node->itemCount == 0) node->status = QT_PARTIALLY_OCCUPIED;
+    else {
+        node->status = QT_CONTAINS_ITEM;
+        for (QuadtreeItem* item = node->items; item; item = item->next) {
+            if (RectContains(item->bounds, node->bounds)) {
+                node->status = QT_FULLY_OCCUPIED;
+                break;
+            }
+        }
+    }
+}
+
+// Keeps subtreeCount and the status right from node up to the root
+static void AdjustCounts(QuadtreeNode* node, long delta) {
+    for (; node; node = node->parent) {
+        node->subtreeCount += delta;
+        UpdateStatus(node);
+    }
+}
+
+static void Link(QuadtreeNode* node, QuadtreeItem* item) {
+    item->node = node;
+    item->prev = NULL;
+    item->next = node->items;
+    if (node->items) node->items->prev = item;
+    node->items = item;
+    node->itemCount++;
+}
+
+static void Unlink(QuadtreeItem* item) {
+    QuadtreeNode* node = item->node;
+    if (item->prev) item->prev->next = item->next;
+    else node->items = item->next;
+    if (item->next) item->next->prev = item->prev;
+    node->itemCount--;
+    item->node = NULL;
+}
+
+static int ChildFor(const QuadtreeNode* node, Rect bounds) {
+    if (node->children[0] == NULL) return -1;
+    for (int i = 0; i < 4; i++) {
+        if (RectContains(node->children[i]->bounds, bounds)) return i;
+    }
+    return -1;
+}
+
+// ----------- Structure -----------
+
+static void Split(Quadtree* tree, QuadtreeNode* node) {
+    QuadtreeNode* children[4];
+    for (int i = 0; i < 4; i++) {
+        children[i] = NewNode(tree, Quadrant(node->bounds, i), node);
+        if (children[i] == NULL) {
+            for (int j = 0; j < i; j++) PoolFree(&tree->nodes, children[j]);
+            return;
+        }
+    }
+    memcpy(node->children, children, sizeof(children));
+
+    // Push down whatever fits into a quadrant, the rest straddles the split lines
+    QuadtreeItem* item = node->items;
+    while (item) {
+        QuadtreeItem* next = item->next;
+        int child = ChildFor(node, item->bounds);
+        if (child >= 0) {
+            Unlink(item);
+            Link(node->children[child], item);
+            node->children[child]->subtreeCount++;
+        }
+        item = next;
+    }
+
+    for (int i = 0; i < 4; i++) UpdateStatus(node->children[i]);
+    UpdateStatus(node);
+}
+
+// Folds the children of nodes that got sparse back into them, from node upwards
+static void Merge(Quadtree* tree, QuadtreeNode* node) {
+    for (; node; node = node->parent) {
+        if (node->children[0] == NULL || node->subtreeCount > QUADTREE_NODE_CAPACITY / 2) continue;
+
+        int leaves = 1;
+        for (int i = 0; i < 4; i++) leaves &= node->children[i]->children[0] == NULL;
+        if (!leaves) continue;
+
+        for (int i = 0; i < 4; i++) {
+            QuadtreeNode* child = node->children[i];
+            while (child->items) {
+                QuadtreeItem* item = child->items;
+                Unlink(item);
+                Link(node, item);
+            }
+            PoolFree(&tree->nodes, child);
+            node->children[i] = NULL;
+        }
+        UpdateStatus(node);
+    }
+}
+
+// Doubles the root towards bounds until it is covered, the old root becomes one quadrant of the new one
+static void GrowRoot(Quadtree* tree, Rect bounds) {
+    for (int growth = 0; growth < QUADTREE_MAX_GROWTH && !RectContains(tree->root->bounds, bounds); growth++) {
+        QuadtreeNode* old = tree->root;
+        Rect area = old->bounds;
+        if (area.size.x <= 0) area.size.x = 1;
+        if (area.size.y <= 0) area.size.y = 1;
+
+        int left = bounds.position.x < area.position.x;
+        int up = bounds.position.y < area.position.y;
+        Rect grown = {
+            {left ? area.position.x - area.size.x : area.position.x, up ? area.position.y - area.size.y : area.position.y},
+            {area.size.x * 2, area.size.y * 2}
+        };
+
+        QuadtreeNode* root = NewNode(tree, grown, NULL);
+        if (root == NULL) return;
+
+        int oldIndex = left + up * 2;
+        for (int i = 0; i < 4; i++) {
+            if (i == oldIndex) continue;
+            root->children[i] = NewNode(tree, Quadrant(grown, i), root);
+            if (root->children[i] == NULL) {
+                for (int j = 0; j < i; j++) if (root->children[j]) PoolFree(&tree->nodes, root->children[j]);
+                PoolFree(&tree->nodes, root);
+                return;
+            }
+        }
+
+        old->bounds = Quadrant(grown, oldIndex);
+        old->parent = root;
+        root->children[oldIndex] = old;
+        root->subtreeCount = old->subtreeCount;
+        UpdateStatus(root);
+        tree->root = root;
+    }
+}
+
+static void Place(Quadtree* tree, QuadtreeItem* item) {
+    GrowRoot(tree, item->bounds);
+
+    QuadtreeNode* node = tree->root;
+    for (int child = ChildFor(node, item->bounds); child >= 0; child = ChildFor(node, item->bounds)) {
+        node = node->children[child];
+    }
+
+    Link(node, item);
+    AdjustCounts(node, 1);
+
+    if (node->children[0] == NULL && node->itemCount > QUADTREE_NODE_CAPACITY &&
+        node->bounds.size.x >= 2 * QUADTREE_MIN_NODE_SIZE && node->bounds.size.y >= 2 * QUADTREE_MIN_NODE_SIZE) {
+        Split(tree, node);
+    }
+}
+
+// ----------- Quadtree -----------
+
+void QuadtreeInit(Quadtree* tree, Rect bounds) {
+    PoolInit(&tree->nodes, sizeof(QuadtreeNode));
+    PoolInit(&tree->items, sizeof(QuadtreeItem));
+    tree->count = 0;
+    tree->root = NewNode(tree, bounds, NULL);
+}
+
+void QuadtreeDestroy(Quadtree* tree) {
+    PoolDestroy(&tree->nodes);
+    PoolDestroy(&tree->items);
+    tree->root = NULL;
+    tree->count = 0;
+}
+
+QuadtreeItem* QuadtreeInsert(Quadtree* tree, Element* element, Rect bounds) {
+    if (tree->root == NULL) return NULL;
+
+    QuadtreeItem* item = PoolAlloc(&tree->items);
+    if (item == NULL) {
+        fprintf(stderr, "Error: Quadtree item allocation failed.\n");
+        return NULL;
+    }
+
+    memset(item, 0, sizeof(QuadtreeItem));
+    item->element = element;
+    item->bounds = bounds;
+    Place(tree, item);
+    tree->count++;
+    return item;
+}
+
+void QuadtreeRemove(Quadtree* tree, QuadtreeItem* item) {
+    QuadtreeNode* node = item->node;
+    Unlink(item);
+    AdjustCounts(node, -1);
+    Merge(tree, node);
+
+    PoolFree(&tree->items, item);
+    tree->count--;
+}
+
+void QuadtreeMove(Quadtree* tree, QuadtreeItem* item, Rect bounds) {
+    QuadtreeNode* node = item->node;
+    item->bounds = bounds;
+
+    // Still the smallest node around it, which is all moves within a node cost
+    if (RectContains(node->bounds, bounds) && ChildFor(node, bounds) < 0) {
+        UpdateStatus(node);
+        return;
+    }
+
+    Unlink(item);
+    AdjustCounts(node, -1);
+    Place(tree, item);
+    Merge(tree, node);
+}
+
+static void CollectUnstamped(const QuadtreeNode* node, uint32_t stamp, QuadtreeItem** items, size_t* count) {
+    if (node->status == QT_EMPTY) return;
+
+    for (QuadtreeItem* item = node->items; item; item = item->next) {
+        if (item->stamp != stamp) items[(*count)++] = item;
+    }
+
+    if (node->children[0] == NULL) return;
+    for (int i = 0; i < 4; i++) CollectUnstamped(node->children[i], stamp, items, count);
+}
+
+void QuadtreeRemoveUnstamped(Quadtree* tree, uint32_t stamp) {
+    if (tree->root == NULL || tree->count == 0) return;
+
+    // Removing merges nodes, so the items are gathered before the first one goes
+    QuadtreeItem** items = malloc(tree->count * sizeof(QuadtreeItem*));
+    if (items == NULL) {
+        fprintf(stderr, "Error: Quadtree removal list allocation failed.\n");
+        return;
+    }
+
+    size_t count = 0;
+    CollectUnstamped(tree->root, stamp, items, &count);
+    for (size_t i = 0; i < count; i++) QuadtreeRemove(tree, items[i]);
+    free(items);
+}
+
+// ----------- Queries -----------
+
+typedef struct {
+    QuadtreeItem** results;
+    size_t maxResults;
+    size_t found;
+} QueryState;
+
+static void Record(QueryState* state, QuadtreeItem* item) {
+    if (state->found < state->maxResults) state->results[state->found] = item;
+    state->found++;
+}
+
+static void QueryRange(const QuadtreeNode* node, Rect range, QueryState* state) {
+    if (node->status == QT_EMPTY) return;
+
+    for (QuadtreeItem* item = node->items; item; item = item->next) {
+        if (RectsOverlap(item->bounds, range)) Record(state, item);
+    }
+
+    if (node->children[0] == NULL) return;
+    for (int i = 0; i < 4; i++) {
+        if (RectsOverlap(node->children[i]->bounds, range)) QueryRange(node->children[i], range, state);
+    }
+}
+
+static void QueryPoint(const QuadtreeNode* node, Vector2 point, QueryState* state) {
+    if (node->status == QT_EMPTY) return;
+
+    for (QuadtreeItem* item = node->items; item; item = item->next) {
+        if (RectContainsPoint(item->bounds, point)) Record(state, item);
+    }
+
+    if (node->children[0] == NULL) return;
+    for (int i = 0; i < 4; i++) {
+        if (RectContainsPoint(node->children[i]->bounds, point)) QueryPoint(node->children[i], point, state);
+    }
+}
+
+size_t QuadtreeQueryRange(const Quadtree* tree, Rect range, QuadtreeItem** results, size_t maxResults) {
+    QueryState state = {results, maxResults, 0};
+    // Root items are always tested, they may lie outside of it when growth gave up
+    if (tree->root) QueryRange(tree->root, range, &state);
+    return state.found;
+}
+
+size_t QuadtreeQueryPoint(const Quadtree* tree, Vector2 point, QuadtreeItem** results, size_t maxResults) {
+    QueryState state = {results, maxResults, 0};
+    if (tree->root) QueryPoint(tree->root, point, &state);
+    return state.found;
+}
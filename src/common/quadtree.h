@@ -1,21 +1,80 @@
 #ifndef QUADTREE_H
 #define QUADTREE_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include "elements.h"
 #include "types.h"
 
+// Items a node holds before it splits, items that straddle a split line stay in the node
+#define QUADTREE_NODE_CAPACITY 8
+// Nodes smaller than this never split, keeps piles of tiny items from recursing forever
+#define QUADTREE_MIN_NODE_SIZE 8.0f
+// Nodes and items are carved out of blocks this many at a time
+#define QUADTREE_POOL_BLOCK 256
+
 typedef enum {
-    QT_EMPTY,
-    QT_PARTIALLY_OCCUPIED,
-    QT_FULLY_OCCUPIED,
-    QT_CONTAINS_ITEM
+    QT_EMPTY,              // Nothing in the node or below it
+    QT_PARTIALLY_OCCUPIED, // Only the children hold items
+    QT_FULLY_OCCUPIED,     // An item of the node covers all of it
+    QT_CONTAINS_ITEM       // The node holds items itself
 } NodeStatus;
 
+// An element in the tree, lives in the smallest node that fully contains its bounds
+typedef struct QuadtreeItem {
+    Element* element;
+    Rect bounds;
+    const void* parent; // What the element was added to, the section or NULL for the window
+    size_t order;       // Pre-order position in the element tree, higher is drawn later
+    uint32_t stamp;     // Set by the owner, see QuadtreeRemoveUnstamped
+
+    struct QuadtreeNode* node;
+    struct QuadtreeItem* prev;
+    struct QuadtreeItem* next;
+} QuadtreeItem;
+
 typedef struct QuadtreeNode {
     Rect bounds;
     NodeStatus status;
-    struct QuadtreeNode *children[4];
-    Element *inhabitant; 
+    struct QuadtreeNode *children[4]; // All NULL or all set, quadrants in reading order
+    struct QuadtreeNode *parent;
+    QuadtreeItem* items;
+    size_t itemCount;    // Items in this node
+    size_t subtreeCount; // Items in this node and every node below it
 } QuadtreeNode;
 
-#endif
\ No newline at end of file
+// Fixed size slots handed out from blocks that never move, freed slots go on a free list
+typedef struct QuadtreePool {
+    void** blocks;
+    size_t blockCount;
+    size_t slotSize;
+    size_t used; // Slots taken from the newest block
+    void* free;
+} QuadtreePool;
+
+typedef struct Quadtree {
+    QuadtreeNode* root; // Grows outwards when an item lands outside of it
+    QuadtreePool nodes;
+    QuadtreePool items;
+    size_t count;
+} Quadtree;
+
+void QuadtreeInit(Quadtree* tree, Rect bounds);
+void QuadtreeDestroy(Quadtree* tree);
+
+// Returns NULL when the pool can not grow
+QuadtreeItem* QuadtreeInsert(Quadtree* tree, Element* element, Rect bounds);
+void QuadtreeRemove(Quadtree* tree, QuadtreeItem* item);
+// Updates the bounds of an item, only relinks it when it leaves its node
+void QuadtreeMove(Quadtree* tree, QuadtreeItem* item, Rect bounds);
+// Removes every item whose stamp is not stamp, for owners that stamp the items they still hold and drop the rest
+void QuadtreeRemoveUnstamped(Quadtree* tree, uint32_t stamp);
+
+// Writes up to maxResults items overlapping range into results and returns how many overlap in total,
+// so callers can grow results and ask again
+size_t QuadtreeQueryRange(const Quadtree* tree, Rect range, QuadtreeItem** results, size_t maxResults);
+// Same as QuadtreeQueryRange for the items containing point
+size_t QuadtreeQueryPoint(const Quadtree* tree, Vector2 point, QuadtreeItem** results, size_t maxResults);
+
+#endif
@@ -1,5 +1,44 @@
 #include "shader.h"
 
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#define MakeDirectory(path) _mkdir(path)
+#else
+#include <sys/stat.h>
+#define MakeDirectory(path) mkdir(path, 0755)
+#endif
+
+// GL_ARB_get_program_binary, core since 4.1
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+
+typedef void (APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+typedef void (APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+typedef void (APIENTRYP ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+
+// GL_KHR_parallel_shader_compile, also exposed as GL_ARB_parallel_shader_compile
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+
+typedef void (APIENTRYP MaxShaderCompilerThreadsProc)(GLuint count);
+
+#define BINARY_CACHE_MAGIC 0x42504c47u // "GLPB"
+#define CACHE_PATH_SIZE 1024
+
+typedef struct {
+    uint32_t magic;
+    uint32_t format;
+    uint32_t length;
+} BinaryCacheHeader;
+
+static const char* cacheDirectory = NULL;
+static GetProgramBinaryProc getProgramBinary;
+static ProgramBinaryProc programBinary;
+static ProgramParameteriProc programParameteri;
+static int parallelCompile = 0;
+
 // --- Helper function to read file contents into a string ---
 char* readFile(const char* path) {
     FILE *fp;
@@ -49,7 +88,205 @@ void checkCompileErrors(unsigned int shader, const char* type) {
     }
 }
 
+// --- Program Binary Cache ---
+
+int ShaderEnableBinaryCache(const char* directory, void* (*loader)(const char* name)) {
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    // Drivers without the extension reject the enum, clear the error it leaves
+    while (glGetError() != GL_NO_ERROR) {}
+
+    getProgramBinary = (GetProgramBinaryProc)loader("glGetProgramBinary");
+    programBinary = (ProgramBinaryProc)loader("glProgramBinary");
+    programParameteri = (ProgramParameteriProc)loader("glProgramParameteri");
+
+    if (formats <= 0 || !getProgramBinary || !programBinary || !programParameteri) {
+        cacheDirectory = NULL;
+        return 0;
+    }
+
+    MakeDirectory(directory);
+    cacheDirectory = directory;
+    return 1;
+}
+
+// 64 bit FNV-1a, chained through hash
+static uint64_t HashString(uint64_t hash, const char* text) {
+    if (text == NULL) text = "";
+    for (const unsigned char* c = (const unsigned char*)text; *c; c++) {
+        hash ^= *c;
+        hash *= 0x100000001b3ull;
+    }
+    // Separator so "ab" + "c" and "a" + "bc" differ
+    hash ^= 0xff;
+    hash *= 0x100000001b3ull;
+    return hash;
+}
+
+// The driver strings are part of the key since binaries are only valid for the driver that made them
+static uint64_t CacheKey(const char* vertexCode, const char* fragmentCode) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    hash = HashString(hash, vertexCode);
+    hash = HashString(hash, fragmentCode);
+    hash = HashString(hash, (const char*)glGetString(GL_VENDOR));
+    hash = HashString(hash, (const char*)glGetString(GL_RENDERER));
+    hash = HashString(hash, (const char*)glGetString(GL_VERSION));
+    return hash;
+}
+
+static void CachePath(char* path, uint64_t key) {
+    snprintf(path, CACHE_PATH_SIZE, "%s/%016llx.bin", cacheDirectory, (unsigned long long)key);
+}
+
+// Returns 1 when program was linked from the cached binary
+static int LoadCachedProgram(unsigned int program, const char* path) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return 0;
+
+    BinaryCacheHeader header;
+    void* binary = NULL;
+    int linked = 0;
+
+    if (fread(&header, sizeof(header), 1, fp) == 1 && header.magic == BINARY_CACHE_MAGIC &&
+        (binary = malloc(header.length)) != NULL && fread(binary, 1, header.length, fp) == header.length) {
+        programBinary(program, header.format, binary, (GLsizei)header.length);
+        // Drivers reject binaries after updates, that shows up as a failed link
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    }
+
+    free(binary);
+    fclose(fp);
+
+    if (!linked) remove(path);
+    return linked;
+}
+
+static void StoreCachedProgram(unsigned int program, const char* path) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    void* binary = malloc(length);
+    if (!binary) return;
+
+    GLenum format = 0;
+    getProgramBinary(program, length, NULL, &format, binary);
+
+    FILE* fp = fopen(path, "wb");
+    if (fp) {
+        BinaryCacheHeader header = {BINARY_CACHE_MAGIC, format, (uint32_t)length};
+        fwrite(&header, sizeof(header), 1, fp);
+        fwrite(binary, 1, length, fp);
+        fclose(fp);
+    }
+    free(binary);
+}
+
+// --- Parallel Compilation ---
+
+int ShaderEnableParallelCompile(void* (*loader)(const char* name)) {
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+
+    for (GLint i = 0; i < extensionCount; i++) {
+        const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if (!extension) continue;
+
+        MaxShaderCompilerThreadsProc maxThreads = NULL;
+        if (strcmp(extension, "GL_KHR_parallel_shader_compile") == 0)
+            maxThreads = (MaxShaderCompilerThreadsProc)loader("glMaxShaderCompilerThreadsKHR");
+        else if (strcmp(extension, "GL_ARB_parallel_shader_compile") == 0)
+            maxThreads = (MaxShaderCompilerThreadsProc)loader("glMaxShaderCompilerThreadsARB");
+
+        if (maxThreads) {
+            // Let the driver pick how many threads it compiles on
+            maxThreads(0xFFFFFFFFu);
+            parallelCompile = 1;
+            return 1;
+        }
+    }
+
+    parallelCompile = 0;
+    return 0;
+}
+
 // --- Initialization Function (replaces constructor) ---
+
+int ShaderBeginCompile(Shader* s, const char* vertexCode, const char* fragmentCode) {
+    s->ID = glCreateProgram();
+    s->vertex = 0;
+    s->fragment = 0;
+    s->ready = 0;
+    s->linked = 0;
+    s->cacheKey = 0;
+
+    // 1. Try the binary cache before compiling anything
+    if (cacheDirectory) {
+        char cachePath[CACHE_PATH_SIZE];
+        s->cacheKey = CacheKey(vertexCode, fragmentCode);
+        CachePath(cachePath, s->cacheKey);
+        if (LoadCachedProgram(s->ID, cachePath)) {
+            s->ready = 1;
+            s->linked = 1;
+            return 1;
+        }
+    }
+
+    // 2. Compile shaders, errors are only checked once the program is polled so nothing waits here
+
+    // Vertex Shader
+    s->vertex = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(s->vertex, 1, (const GLchar* const*)&vertexCode, NULL);
+    glCompileShader(s->vertex);
+
+    // Fragment Shader
+    s->fragment = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(s->fragment, 1, (const GLchar* const*)&fragmentCode, NULL);
+    glCompileShader(s->fragment);
+
+    // 3. Shader Program Link
+    glAttachShader(s->ID, s->vertex);
+    glAttachShader(s->ID, s->fragment);
+    if (cacheDirectory) programParameteri(s->ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(s->ID);
+
+    return 1;
+}
+
+int ShaderPoll(Shader* s) {
+    if (s->ready) return 1;
+
+    // Without the extension any status query waits for the compile, so there is nothing to poll
+    if (parallelCompile) {
+        GLint complete = 0;
+        glGetProgramiv(s->ID, GL_COMPLETION_STATUS_KHR, &complete);
+        if (!complete) return 0;
+    }
+
+    checkCompileErrors(s->vertex, "VERTEX");
+    checkCompileErrors(s->fragment, "FRAGMENT");
+    checkCompileErrors(s->ID, "PROGRAM");
+
+    GLint linked = 0;
+    glGetProgramiv(s->ID, GL_LINK_STATUS, &linked);
+    s->linked = linked;
+    s->ready = 1;
+
+    if (cacheDirectory && linked) {
+        char cachePath[CACHE_PATH_SIZE];
+        CachePath(cachePath, s->cacheKey);
+        StoreCachedProgram(s->ID, cachePath);
+    }
+
+    // Delete the shaders as they're linked into our program now and no longer necessary
+    glDeleteShader(s->vertex);
+    glDeleteShader(s->fragment);
+    s->vertex = 0;
+    s->fragment = 0;
+
+    return 1;
+}
+
 int CreateShader(Shader* s, const char* vertexPath, const char* fragmentPath) {
     // 1. Retrieve the vertex/fragment source code from files
     char* vShaderCode = readFile(vertexPath);
@@ -62,36 +299,15 @@ int CreateShader(Shader* s, const char* vertexPath, const char* fragmentPath) {
         return 0; // Failure
     }
 
-    // 2. Compile shaders
-    unsigned int vertex, fragment;
-
-    // Vertex Shader
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, (const GLchar* const*)&vShaderCode, NULL);
-    glCompileShader(vertex);
-    checkCompileErrors(vertex, "VERTEX");
-    
-    // Fragment Shader
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, (const GLchar* const*)&fShaderCode, NULL);
-    glCompileShader(fragment);
-    checkCompileErrors(fragment, "FRAGMENT");
+    ShaderBeginCompile(s, vShaderCode, fShaderCode);
 
     // Free the dynamically allocated strings after they are passed to OpenGL
     free(vShaderCode);
     free(fShaderCode);
 
-    // 3. Shader Program Link
-    s->ID = glCreateProgram();
-    glAttachShader(s->ID, vertex);
-    glAttachShader(s->ID, fragment);
-    glLinkProgram(s->ID);
-    checkCompileErrors(s->ID, "PROGRAM");
+    // Blocks until the program is linked
+    while (!ShaderPoll(s)) {}
 
-    // Delete the shaders as they're linked into our program now and no longer necessary
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
-    
     return 1; // Success
 }
 
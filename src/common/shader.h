@@ -8,12 +8,36 @@
 #include <glad/glad.h>
 #include <GL/gl.h> // Or use GL/gl.h, depending on your setup
 
+#include <stdint.h>
+
 typedef struct {
     unsigned int ID;
+    // Only used while the program is compiling, see ShaderBeginCompile
+    unsigned int vertex;
+    unsigned int fragment;
+    int ready;
+    int linked;
+    uint64_t cacheKey;
 } Shader;
 
+// Reads, compiles and links a program from files, waiting until it is done
 int CreateShader(Shader *s, const char* vertexPath, const char* fragmentPath);
 
+// Starts compiling and linking a program from source without waiting for the driver.
+// Begin every program first and poll afterwards so the compiles overlap.
+int ShaderBeginCompile(Shader *s, const char* vertexCode, const char* fragmentCode);
+// Returns 1 once the program finished linking, s->linked then tells if it succeeded
+int ShaderPoll(Shader *s);
+
+// Lets the driver compile on its own threads with GL_KHR_parallel_shader_compile, which also makes ShaderPoll non blocking.
+// Returns 0 when the extension is missing.
+int ShaderEnableParallelCompile(void* (*loader)(const char* name));
+
+// Makes CreateShader keep linked program binaries in directory, keyed by a hash of the sources and the driver.
+// The GL_ARB_get_program_binary functions are not part of the 3.3 core profile glad loads, so they come from loader.
+// Returns 0 when the driver has no binary formats, CreateShader then always compiles.
+int ShaderEnableBinaryCache(const char* directory, void* (*loader)(const char* name));
+
 void ShaderUse(const Shader* s);
 
 // --- Utility Uniform Functions ---
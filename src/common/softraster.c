@@ -0,0 +1,441 @@
+#include "softraster.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Counts the bands of one SoftRasterize call still running on the pool
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t finished;
+    int pending;
+} RasterLatch;
+
+typedef struct {
+    SoftFramebuffer* framebuffer;
+    const DrawList* list;
+    const SoftTexture* textures;
+    size_t textureCount;
+    int firstTileRow;
+    int tileRowStep;
+    RasterLatch* latch;
+} RasterJob;
+
+// ----------- Framebuffer -----------
+
+int SoftCreateFramebuffer(SoftFramebuffer* framebuffer, Vector2i size) {
+    memset(framebuffer, 0, sizeof(SoftFramebuffer));
+    framebuffer->size = size;
+    framebuffer->pixels = calloc((size_t)size.x * size.y, 4);
+    if (framebuffer->pixels == NULL) {
+        fprintf(stderr, "ERROR::SOFTRASTER::FRAMEBUFFER_ALLOCATION_FAILED\n");
+        return 1;
+    }
+    return 0;
+}
+
+void SoftDestroyFramebuffer(SoftFramebuffer* framebuffer) {
+    free(framebuffer->pixels);
+    free(framebuffer->bins);
+    free(framebuffer->binStarts);
+    memset(framebuffer, 0, sizeof(SoftFramebuffer));
+}
+
+int SoftResizeFramebuffer(SoftFramebuffer* framebuffer, Vector2i size) {
+    uint8_t* pixels = realloc(framebuffer->pixels, (size_t)size.x * size.y * 4);
+    if (pixels == NULL) {
+        fprintf(stderr, "ERROR::SOFTRASTER::FRAMEBUFFER_ALLOCATION_FAILED\n");
+        return 1;
+    }
+
+    framebuffer->pixels = pixels;
+    framebuffer->size = size;
+    return 0;
+}
+
+static uint32_t PackColor(Color color, uint8_t alpha) {
+    uint8_t bytes[4] = {color.red, color.green, color.blue, alpha};
+    uint32_t packed;
+    memcpy(&packed, bytes, sizeof(packed));
+    return packed;
+}
+
+// ----------- Spans -----------
+
+static void FillSpan(uint8_t* dst, int count, uint32_t packed) {
+    int i = 0;
+#if defined(__AVX2__)
+    __m256i color8 = _mm256_set1_epi32((int)packed);
+    for (; i + 8 <= count; i += 8) _mm256_storeu_si256((__m256i*)(dst + i * 4), color8);
+#endif
+#if defined(__SSE2__)
+    __m128i color4 = _mm_set1_epi32((int)packed);
+    for (; i + 4 <= count; i += 4) _mm_storeu_si128((__m128i*)(dst + i * 4), color4);
+#endif
+    for (; i < count; i++) memcpy(dst + i * 4, &packed, 4);
+}
+
+static uint8_t BlendChannel(uint8_t src, uint8_t dst, uint8_t alpha) {
+    unsigned int x = src * alpha + dst * (255u - alpha) + 128u;
+    return (uint8_t)((x + (x >> 8)) >> 8);
+}
+
+// dst = src * coverage + dst * (1 - coverage), the divide by 255 is done exactly with (x + x / 256) / 256
+static void BlendSpan(uint8_t* dst, const uint8_t* coverage, int count, Color color) {
+    int i = 0;
+#if defined(__AVX2__)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i full = _mm256_set1_epi16(255);
+        const __m256i half = _mm256_set1_epi16(128);
+        const __m256i src = _mm256_set_epi16(255, color.blue, color.green, color.red, 255, color.blue, color.green, color.red,
+                                             255, color.blue, color.green, color.red, 255, color.blue, color.green, color.red);
+        for (; i + 8 <= count; i += 8) {
+            __m256i pixels = _mm256_loadu_si256((const __m256i*)(dst + i * 4));
+
+            // Spread each coverage byte over the four channels of its pixel
+            __m128i cov = _mm_loadl_epi64((const __m128i*)(coverage + i));
+            cov = _mm_unpacklo_epi8(cov, cov);
+            __m128i covLo = _mm_unpacklo_epi16(cov, cov);
+            __m128i covHi = _mm_unpackhi_epi16(cov, cov);
+            // unpack on 256 bits works per 128 bit lane, so match that layout
+            __m256i alpha = _mm256_set_m128i(covHi, covLo);
+            __m256i alphaLo = _mm256_unpacklo_epi8(alpha, zero);
+            __m256i alphaHi = _mm256_unpackhi_epi8(alpha, zero);
+
+            __m256i dstLo = _mm256_unpacklo_epi8(pixels, zero);
+            __m256i dstHi = _mm256_unpackhi_epi8(pixels, zero);
+
+            __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(src, alphaLo), _mm256_mullo_epi16(dstLo, _mm256_sub_epi16(full, alphaLo)));
+            __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(src, alphaHi), _mm256_mullo_epi16(dstHi, _mm256_sub_epi16(full, alphaHi)));
+            lo = _mm256_add_epi16(lo, half);
+            hi = _mm256_add_epi16(hi, half);
+            lo = _mm256_srli_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), 8);
+            hi = _mm256_srli_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), 8);
+
+            _mm256_storeu_si256((__m256i*)(dst + i * 4), _mm256_packus_epi16(lo, hi));
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i full = _mm_set1_epi16(255);
+        const __m128i half = _mm_set1_epi16(128);
+        const __m128i src = _mm_set_epi16(255, color.blue, color.green, color.red, 255, color.blue, color.green, color.red);
+        for (; i + 4 <= count; i += 4) {
+            __m128i pixels = _mm_loadu_si128((const __m128i*)(dst + i * 4));
+
+            uint32_t packedCoverage;
+            memcpy(&packedCoverage, coverage + i, 4);
+            __m128i cov = _mm_cvtsi32_si128((int)packedCoverage);
+            cov = _mm_unpacklo_epi8(cov, cov);
+            cov = _mm_unpacklo_epi16(cov, cov);
+            __m128i alphaLo = _mm_unpacklo_epi8(cov, zero);
+            __m128i alphaHi = _mm_unpackhi_epi8(cov, zero);
+
+            __m128i dstLo = _mm_unpacklo_epi8(pixels, zero);
+            __m128i dstHi = _mm_unpackhi_epi8(pixels, zero);
+
+            __m128i lo = _mm_add_epi16(_mm_mullo_epi16(src, alphaLo), _mm_mullo_epi16(dstLo, _mm_sub_epi16(full, alphaLo)));
+            __m128i hi = _mm_add_epi16(_mm_mullo_epi16(src, alphaHi), _mm_mullo_epi16(dstHi, _mm_sub_epi16(full, alphaHi)));
+            lo = _mm_add_epi16(lo, half);
+            hi = _mm_add_epi16(hi, half);
+            lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+            _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_packus_epi16(lo, hi));
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        uint8_t* pixel = dst + i * 4;
+        pixel[0] = BlendChannel(color.red, pixel[0], coverage[i]);
+        pixel[1] = BlendChannel(color.green, pixel[1], coverage[i]);
+        pixel[2] = BlendChannel(color.blue, pixel[2], coverage[i]);
+        pixel[3] = BlendChannel(255, pixel[3], coverage[i]);
+    }
+}
+
+// dst = texel * color * texel alpha + dst * (1 - texel alpha), with texels picked from a row by columns
+static void BlendTexelSpan(uint8_t* dst, const uint8_t* texels, const int* columns, int count, Color color) {
+    for (int i = 0; i < count; i++) {
+        const uint8_t* texel = texels + columns[i] * 4;
+        uint8_t alpha = (uint8_t)((texel[3] * color.alpha + 127) / 255);
+        if (alpha == 0) continue;
+
+        uint8_t* pixel = dst + i * 4;
+        pixel[0] = BlendChannel((uint8_t)((texel[0] * color.red + 127) / 255), pixel[0], alpha);
+        pixel[1] = BlendChannel((uint8_t)((texel[1] * color.green + 127) / 255), pixel[1], alpha);
+        pixel[2] = BlendChannel((uint8_t)((texel[2] * color.blue + 127) / 255), pixel[2], alpha);
+        pixel[3] = BlendChannel(255, pixel[3], alpha);
+    }
+}
+
+void SoftClear(SoftFramebuffer* framebuffer, Color color) {
+    FillSpan(framebuffer->pixels, framebuffer->size.x * framebuffer->size.y, PackColor(color, 255));
+}
+
+// ----------- Quads -----------
+
+// Same distance the UI fragment shader measures, p is the offset from the rect center
+static uint8_t RoundedRectCoverage(float px, float py, const float* shape) {
+    float cornerX = fabsf(px) - shape[0] + shape[2];
+    float cornerY = fabsf(py) - shape[1] + shape[2];
+    float outsideX = cornerX > 0 ? cornerX : 0, outsideY = cornerY > 0 ? cornerY : 0;
+    float inside = cornerX > cornerY ? cornerX : cornerY;
+    float distance = sqrtf(outsideX * outsideX + outsideY * outsideY) + (inside < 0 ? inside : 0) - shape[2];
+
+    float alpha = 0.5f - distance;
+    return alpha <= 0 ? 0 : alpha >= 1 ? 255 : (uint8_t)(alpha * 255.0f + 0.5f);
+}
+
+static void ScaleCoverage(uint8_t* coverage, int count, uint8_t alpha) {
+    if (alpha == 255) return;
+    for (int x = 0; x < count; x++) coverage[x] = (uint8_t)((coverage[x] * alpha + 127) / 255);
+}
+
+// Draws one quad, clipped to the rows [clipTop, clipBottom)
+static void RasterizeQuad(const RasterJob* job, const DrawCommand* command, unsigned int textureIndex,
+                          const DrawVertex* vertices, int clipTop, int clipBottom, int* columns, uint8_t* coverage) {
+    SoftFramebuffer* framebuffer = job->framebuffer;
+
+    float left = vertices[0].x, right = vertices[0].x, top = vertices[0].y, bottom = vertices[0].y;
+    float u0 = vertices[0].u, u1 = vertices[0].u, v0 = vertices[0].v, v1 = vertices[0].v;
+    for (int i = 1; i < 6; i++) {
+        const DrawVertex* vertex = &vertices[i];
+        if (vertex->x < left)   { left = vertex->x;   u0 = vertex->u; }
+        if (vertex->x > right)  { right = vertex->x;  u1 = vertex->u; }
+        if (vertex->y < top)    { top = vertex->y;    v0 = vertex->v; }
+        if (vertex->y > bottom) { bottom = vertex->y; v1 = vertex->v; }
+    }
+
+    // Pixel centers inside the quad
+    int x0 = (int)ceilf(left - 0.5f), x1 = (int)ceilf(right - 0.5f);
+    int y0 = (int)ceilf(top - 0.5f),  y1 = (int)ceilf(bottom - 0.5f);
+    int clipX0 = x0 < 0 ? 0 : x0;
+    int clipX1 = x1 > framebuffer->size.x ? framebuffer->size.x : x1;
+    int clipY0 = y0 < clipTop ? clipTop : y0;
+    int clipY1 = y1 > clipBottom ? clipBottom : y1;
+    if (clipX0 >= clipX1 || clipY0 >= clipY1) return;
+
+    int width = clipX1 - clipX0;
+    size_t stride = (size_t)framebuffer->size.x * 4;
+    uint8_t* row = framebuffer->pixels + clipY0 * stride + clipX0 * 4;
+
+    DrawKind kind = (DrawKind)(int)(vertices[0].kind + 0.5f);
+    // Calls merge quads of any color, so it comes from the vertices
+    const uint8_t* rgba = vertices[0].color;
+    Color color = {.red = rgba[0], .green = rgba[1], .blue = rgba[2], .alpha = rgba[3]};
+    float quadWidth = right - left, quadHeight = bottom - top;
+
+    if (kind == DRAW_KIND_ROUNDED_RECT) {
+        for (int y = clipY0; y < clipY1; y++, row += stride) {
+            float v = v0 + (y + 0.5f - top) / quadHeight * (v1 - v0);
+            for (int x = 0; x < width; x++) {
+                float u = u0 + (clipX0 + x + 0.5f - left) / quadWidth * (u1 - u0);
+                coverage[x] = RoundedRectCoverage(u, v, vertices[0].shape);
+            }
+            ScaleCoverage(coverage, width, color.alpha);
+            BlendSpan(row, coverage, width, color);
+        }
+        return;
+    }
+
+    const SoftTexture* texture = kind != DRAW_KIND_SOLID && textureIndex && textureIndex < job->textureCount
+                               ? &job->textures[textureIndex] : NULL;
+
+    if (texture == NULL || (texture->coverage == NULL && texture->rgba == NULL)) {
+        int opaque = command->blend == DRAW_BLEND_NONE || color.alpha == 255;
+        if (!opaque) memset(coverage, color.alpha, (size_t)width);
+
+        for (int y = clipY0; y < clipY1; y++, row += stride) {
+            if (opaque) FillSpan(row, width, PackColor(color, 255));
+            else BlendSpan(row, coverage, width, color);
+        }
+        return;
+    }
+
+    // Nearest sampling, the texel columns are the same for every row of the quad
+    for (int x = 0; x < width; x++) {
+        float u = u0 + (clipX0 + x + 0.5f - left) / quadWidth * (u1 - u0);
+        int column = (int)(u * texture->width);
+        columns[x] = column < 0 ? 0 : column >= texture->width ? texture->width - 1 : column;
+    }
+
+    for (int y = clipY0; y < clipY1; y++, row += stride) {
+        float v = v0 + (y + 0.5f - top) / quadHeight * (v1 - v0);
+        int texelRow = (int)(v * texture->height);
+        texelRow = texelRow < 0 ? 0 : texelRow >= texture->height ? texture->height - 1 : texelRow;
+
+        if (texture->rgba) {
+            BlendTexelSpan(row, texture->rgba + (size_t)texelRow * texture->width * 4, columns, width, color);
+            continue;
+        }
+
+        const uint8_t* texels = texture->coverage + (size_t)texelRow * texture->width;
+        for (int x = 0; x < width; x++) coverage[x] = texels[columns[x]];
+        ScaleCoverage(coverage, width, color.alpha);
+
+        BlendSpan(row, coverage, width, color);
+    }
+}
+
+// ----------- Binning -----------
+
+// Finds the tile rows holding the pixel centers a quad covers, returns false when it covers none
+static bool QuadTileRows(const DrawVertex* vertices, int height, int* first, int* last) {
+    float top = vertices[0].y, bottom = vertices[0].y;
+    for (int i = 1; i < 6; i++) {
+        if (vertices[i].y < top) top = vertices[i].y;
+        if (vertices[i].y > bottom) bottom = vertices[i].y;
+    }
+
+    int y0 = (int)ceilf(top - 0.5f), y1 = (int)ceilf(bottom - 0.5f);
+    if (y0 < 0) y0 = 0;
+    if (y1 > height) y1 = height;
+    if (y0 >= y1) return false;
+
+    *first = y0 / SOFT_TILE_HEIGHT;
+    *last = (y1 - 1) / SOFT_TILE_HEIGHT;
+    return true;
+}
+
+static int GrowBins(void** array, size_t* capacity, size_t needed, size_t itemSize) {
+    if (needed <= *capacity) return 0;
+
+    size_t grown = *capacity ? *capacity : 256;
+    while (grown < needed) grown *= 2;
+    void* items = realloc(*array, grown * itemSize);
+    if (items == NULL) return 1;
+    *array = items;
+    *capacity = grown;
+    return 0;
+}
+
+// Files every quad of the list under the tile rows it touches, in list order so each row keeps the painter order.
+// Counts first and fills second, so the bins are two flat arrays. Returns 1 when they could not grow.
+static int BinQuads(SoftFramebuffer* framebuffer, const DrawList* list, int tileRows) {
+    int height = framebuffer->size.y;
+    if (GrowBins((void**)&framebuffer->binStarts, &framebuffer->binStartCapacity, (size_t)tileRows + 1, sizeof(size_t))) {
+        return 1;
+    }
+    size_t* starts = framebuffer->binStarts;
+    memset(starts, 0, ((size_t)tileRows + 1) * sizeof(size_t));
+
+    int first, last;
+    for (size_t c = 0; c < list->callCount; c++) {
+        const DrawCall* call = &list->calls[c];
+        for (size_t v = 0; v + 6 <= call->vertexCount; v += 6) {
+            if (!QuadTileRows(list->sortedVertices + call->firstVertex + v, height, &first, &last)) continue;
+            for (int row = first; row <= last; row++) starts[row + 1]++;
+        }
+    }
+    for (int row = 0; row < tileRows; row++) starts[row + 1] += starts[row];
+    if (GrowBins((void**)&framebuffer->bins, &framebuffer->binCapacity, starts[tileRows], sizeof(SoftBinnedQuad))) {
+        return 1;
+    }
+
+    // starts[row] is the fill cursor of the row, which leaves it at the start of the next row
+    for (size_t c = 0; c < list->callCount; c++) {
+        const DrawCall* call = &list->calls[c];
+        for (size_t v = 0; v + 6 <= call->vertexCount; v += 6) {
+            size_t vertex = call->firstVertex + v;
+            if (!QuadTileRows(list->sortedVertices + vertex, height, &first, &last)) continue;
+            for (int row = first; row <= last; row++) {
+                framebuffer->bins[starts[row]++] = (SoftBinnedQuad){(uint32_t)c, (uint32_t)vertex};
+            }
+        }
+    }
+    for (int row = tileRows; row > 0; row--) starts[row] = starts[row - 1];
+    starts[0] = 0;
+    return 0;
+}
+
+// ----------- Tile rows -----------
+
+// Each worker owns every tileRowStep'th row of tiles, so no two threads ever write the same pixel
+static void RasterizeTileRows(const RasterJob* job) {
+    const DrawList* list = job->list;
+    const SoftFramebuffer* framebuffer = job->framebuffer;
+    int width = framebuffer->size.x;
+    int height = framebuffer->size.y;
+
+    int* columns = malloc((size_t)width * sizeof(int));
+    uint8_t* coverage = malloc((size_t)width);
+    if (columns == NULL || coverage == NULL) {
+        fprintf(stderr, "ERROR::SOFTRASTER::SPAN_ALLOCATION_FAILED\n");
+        free(columns);
+        free(coverage);
+        return;
+    }
+
+    for (int tileRow = job->firstTileRow; tileRow * SOFT_TILE_HEIGHT < height; tileRow += job->tileRowStep) {
+        int clipTop = tileRow * SOFT_TILE_HEIGHT;
+        int clipBottom = clipTop + SOFT_TILE_HEIGHT > height ? height : clipTop + SOFT_TILE_HEIGHT;
+
+        for (size_t i = framebuffer->binStarts[tileRow]; i < framebuffer->binStarts[tileRow + 1]; i++) {
+            SoftBinnedQuad quad = framebuffer->bins[i];
+            const DrawCall* call = &list->calls[quad.call];
+            RasterizeQuad(job, &list->commands[call->command], call->texture, list->sortedVertices + quad.vertex,
+                          clipTop, clipBottom, columns, coverage);
+        }
+    }
+
+    free(columns);
+    free(coverage);
+}
+
+static void RasterizeTileRowsJob(void* argument) {
+    RasterJob* job = argument;
+    RasterizeTileRows(job);
+
+    pthread_mutex_lock(&job->latch->lock);
+    if (--job->latch->pending == 0) pthread_cond_signal(&job->latch->finished);
+    pthread_mutex_unlock(&job->latch->lock);
+}
+
+void SoftRasterize(SoftFramebuffer* framebuffer, const DrawList* list, const SoftTexture* textures, size_t textureCount,
+                   ThreadPool* pool) {
+    int tileRows = (framebuffer->size.y + SOFT_TILE_HEIGHT - 1) / SOFT_TILE_HEIGHT;
+    if (tileRows < 1) return;
+    if (BinQuads(framebuffer, list, tileRows)) {
+        fprintf(stderr, "ERROR::SOFTRASTER::BIN_ALLOCATION_FAILED\n");
+        return;
+    }
+
+    int threadCount = SOFT_RASTER_THREADS < tileRows ? SOFT_RASTER_THREADS : tileRows;
+    if (pool == NULL || pool->threadCount == 0 || threadCount < 1) threadCount = 1;
+
+    RasterJob jobs[SOFT_RASTER_THREADS > 1 ? SOFT_RASTER_THREADS : 1];
+    RasterLatch latch = {.pending = threadCount - 1};
+    pthread_mutex_init(&latch.lock, NULL);
+    pthread_cond_init(&latch.finished, NULL);
+
+    for (int t = 0; t < threadCount; t++) {
+        jobs[t] = (RasterJob){framebuffer, list, textures, textureCount, t, threadCount, &latch};
+    }
+
+    // The calling thread takes the first share instead of idling, a job the pool could not queue runs here too
+    for (int t = 1; t < threadCount; t++) {
+        if (ThreadPoolSubmit(pool, RasterizeTileRowsJob, &jobs[t])) RasterizeTileRowsJob(&jobs[t]);
+    }
+    RasterizeTileRows(&jobs[0]);
+
+    pthread_mutex_lock(&latch.lock);
+    while (latch.pending > 0) pthread_cond_wait(&latch.finished, &latch.lock);
+    pthread_mutex_unlock(&latch.lock);
+
+    pthread_cond_destroy(&latch.finished);
+    pthread_mutex_destroy(&latch.lock);
+}
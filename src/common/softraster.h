@@ -0,0 +1,63 @@
+#ifndef SOFTRASTER_H
+#define SOFTRASTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "types.h"
+#include "drawlist.h"
+#include "threadpool.h"
+
+// Height in pixels of the rows of tiles handed out to the rasterizer threads
+#define SOFT_TILE_HEIGHT 32
+// Tile row bands SoftRasterize splits a frame into, the calling thread takes one and the pool the rest.
+// 1 rasterizes on the calling thread only.
+#ifndef SOFT_RASTER_THREADS
+#define SOFT_RASTER_THREADS 4
+#endif
+
+// A single channel coverage texture like the glyph bitmaps freetype renders,
+// or an RGBA one for images when rgba is set
+typedef struct SoftTexture {
+    int width;
+    int height;
+    uint8_t* coverage;
+    uint8_t* rgba;
+} SoftTexture;
+
+// A quad of the draw list being rasterized, filed under every tile row it touches
+typedef struct SoftBinnedQuad {
+    uint32_t call;
+    uint32_t vertex; // The first of its 6 sorted vertices
+} SoftBinnedQuad;
+
+// Tightly packed RGBA pixels, top row first
+typedef struct SoftFramebuffer {
+    Vector2i size;
+    uint8_t* pixels;
+    // The quads of the last frame by tile row, tile row r owns bins[binStarts[r], binStarts[r + 1]).
+    // Kept between frames so binning stops allocating once the arrays are big enough.
+    SoftBinnedQuad* bins;
+    size_t binCapacity;
+    size_t* binStarts;
+    size_t binStartCapacity;
+} SoftFramebuffer;
+
+int SoftCreateFramebuffer(SoftFramebuffer* framebuffer, Vector2i size);
+void SoftDestroyFramebuffer(SoftFramebuffer* framebuffer);
+// Keeps the old pixels when the allocation fails
+int SoftResizeFramebuffer(SoftFramebuffer* framebuffer, Vector2i size);
+
+void SoftClear(SoftFramebuffer* framebuffer, Color color);
+
+// Draws the calls of a sorted draw list.
+// Every primitive guilay records is an axis aligned quad of 6 vertices, which is all this handles.
+// The quads are binned by tile row once, so every band only walks the quads that touch it.
+// Call textures index into textures, texture 0 is reserved for solid fills of the vertex color.
+// Images sample RGBA textures tinted by the vertex color, always with nearest sampling.
+// Bands after the first go to pool, which should be started once with SOFT_RASTER_THREADS - 1 threads and
+// may be shared by several framebuffers. A NULL pool rasterizes everything on the calling thread.
+void SoftRasterize(SoftFramebuffer* framebuffer, const DrawList* list, const SoftTexture* textures, size_t textureCount,
+                   ThreadPool* pool);
+
+#endif
@@ -0,0 +1,105 @@
+#include "stringtable.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void InitStringTable(StringTable* table) {
+    memset(table, 0, sizeof(StringTable));
+    ArenaInit(&table->characters);
+}
+
+void FreeStringTable(StringTable* table) {
+    for (size_t i = 0; i < table->blockCount; i++) free(table->blocks[i]);
+    free(table->blocks);
+    free(table->buckets);
+    ArenaDestroy(&table->characters);
+    InitStringTable(table);
+}
+
+// FNV-1a
+uint32_t HashString(StringView string) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < string.length; i++) {
+        hash ^= (unsigned char)string.data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+InternedString* StringTableGet(const StringTable* table, uint32_t id) {
+    if (id == 0 || id > table->count) return NULL;
+    uint32_t index = id - 1;
+    return &table->blocks[index / STRING_TABLE_BLOCK][index % STRING_TABLE_BLOCK];
+}
+
+static void InsertBucket(uint32_t* buckets, size_t bucketCount, uint32_t hash, uint32_t id) {
+    size_t mask = bucketCount - 1;
+    size_t bucket = hash & mask;
+    while (buckets[bucket]) bucket = (bucket + 1) & mask;
+    buckets[bucket] = id;
+}
+
+static int GrowBuckets(StringTable* table) {
+    size_t bucketCount = table->bucketCount ? table->bucketCount * 2 : 256;
+    uint32_t* buckets = calloc(bucketCount, sizeof(uint32_t));
+    if (buckets == NULL) return 1;
+
+    for (uint32_t id = 1; id <= table->count; id++) {
+        InsertBucket(buckets, bucketCount, StringTableGet(table, id)->hash, id);
+    }
+    free(table->buckets);
+    table->buckets = buckets;
+    table->bucketCount = bucketCount;
+    return 0;
+}
+
+// Makes room for one more entry, returns NULL when memory ran out
+static InternedString* AddEntry(StringTable* table) {
+    if (table->count == UINT32_MAX - 1) return NULL;
+    if ((table->count + 1) * 2 > table->bucketCount && GrowBuckets(table)) return NULL;
+
+    if (table->count == table->blockCount * STRING_TABLE_BLOCK) {
+        InternedString** blocks = realloc(table->blocks, (table->blockCount + 1) * sizeof(InternedString*));
+        if (blocks == NULL) return NULL;
+        table->blocks = blocks;
+
+        InternedString* block = malloc(STRING_TABLE_BLOCK * sizeof(InternedString));
+        if (block == NULL) return NULL;
+        table->blocks[table->blockCount++] = block;
+    }
+
+    table->count++;
+    return StringTableGet(table, table->count);
+}
+
+uint32_t StringTableIntern(StringTable* table, StringView string) {
+    uint32_t hash = HashString(string);
+
+    if (table->bucketCount) {
+        size_t mask = table->bucketCount - 1;
+        for (size_t bucket = hash & mask; table->buckets[bucket]; bucket = (bucket + 1) & mask) {
+            InternedString* entry = StringTableGet(table, table->buckets[bucket]);
+            // Empty views may have no characters at all, which memcmp must not see
+            if (entry->hash == hash && entry->string.length == string.length &&
+                (string.length == 0 || memcmp(entry->string.data, string.data, string.length) == 0)) {
+                return table->buckets[bucket];
+            }
+        }
+    }
+
+    char* copy = ArenaAlloc(&table->characters, string.length + 1);
+    InternedString* entry = copy ? AddEntry(table) : NULL;
+    if (entry == NULL) {
+        fprintf(stderr, "Error: String table allocation failed.\n");
+        return 0;
+    }
+    if (string.length) memcpy(copy, string.data, string.length);
+    copy[string.length] = '\0';
+
+    entry->string = (StringView){copy, string.length};
+    entry->hash = hash;
+    entry->width = -1;
+    InsertBucket(table->buckets, table->bucketCount, hash, table->count);
+    return table->count;
+}
@@ -0,0 +1,38 @@
+#ifndef STRINGTABLE_H
+#define STRINGTABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "arena.h"
+#include "types.h"
+
+// Entries are kept in blocks of this many, blocks never move so entries can be read while the table grows
+#define STRING_TABLE_BLOCK 1024
+
+typedef struct InternedString {
+    StringView string; // 0 terminated copy owned by the table
+    uint32_t hash;
+    float width;       // Advance of the whole string at scale 1, negative until measured
+} InternedString;
+
+// Every distinct string stored once, ids start at 1 so 0 can mean no string
+typedef struct StringTable {
+    InternedString** blocks;
+    size_t blockCount;
+    uint32_t count;
+    uint32_t* buckets; // Ids by hash with linear probing, 0 is empty, kept at most half full
+    size_t bucketCount;
+    Arena characters;
+} StringTable;
+
+void InitStringTable(StringTable* table);
+void FreeStringTable(StringTable* table);
+
+uint32_t HashString(StringView string);
+// Returns the id of string, adding a copy of it the first time. Returns 0 when memory ran out.
+uint32_t StringTableIntern(StringTable* table, StringView string);
+// Returns NULL for ids the table never handed out
+InternedString* StringTableGet(const StringTable* table, uint32_t id);
+
+#endif
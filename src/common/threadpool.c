@@ -0,0 +1,84 @@
+#include "threadpool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static void* ThreadPoolWorker(void* argument) {
+    ThreadPool* pool = argument;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->quit && pool->head == NULL) pthread_cond_wait(&pool->wake, &pool->lock);
+        if (pool->head == NULL) break;
+
+        ThreadPoolTask* task = pool->head;
+        pool->head = task->next;
+        if (pool->head == NULL) pool->tail = NULL;
+        pthread_mutex_unlock(&pool->lock);
+
+        task->job(task->argument);
+        free(task);
+
+        pthread_mutex_lock(&pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+int StartThreadPool(ThreadPool* pool, int threadCount) {
+    pool->threadCount = 0;
+    pool->quit = false;
+    pool->head = NULL;
+    pool->tail = NULL;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+
+    if (threadCount > THREAD_POOL_MAX_THREADS) threadCount = THREAD_POOL_MAX_THREADS;
+    for (int i = 0; i < threadCount; i++) {
+        if (pthread_create(&pool->threads[pool->threadCount], NULL, ThreadPoolWorker, pool) != 0) break;
+        pool->threadCount++;
+    }
+
+    if (pool->threadCount == 0) {
+        fprintf(stderr, "Warning: Could not start pool threads, jobs run on the submitting thread.\n");
+    }
+    return 0;
+}
+
+void StopThreadPool(ThreadPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->threadCount; i++) pthread_join(pool->threads[i], NULL);
+
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+    pool->threadCount = 0;
+}
+
+int ThreadPoolSubmit(ThreadPool* pool, ThreadPoolJob job, void* argument) {
+    if (pool->threadCount == 0) {
+        job(argument);
+        return 0;
+    }
+
+    ThreadPoolTask* task = malloc(sizeof(ThreadPoolTask));
+    if (task == NULL) {
+        fprintf(stderr, "Error: Could not queue a pool job.\n");
+        return 1;
+    }
+    task->job = job;
+    task->argument = argument;
+    task->next = NULL;
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->tail) pool->tail->next = task;
+    else pool->head = task;
+    pool->tail = task;
+    pthread_cond_signal(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
@@ -0,0 +1,36 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define THREAD_POOL_MAX_THREADS 8
+
+typedef void (*ThreadPoolJob)(void* argument);
+
+typedef struct ThreadPoolTask {
+    ThreadPoolJob job;
+    void* argument;
+    struct ThreadPoolTask* next;
+} ThreadPoolTask;
+
+// Runs jobs in submission order on a few worker threads.
+// When no thread could be started, ThreadPoolSubmit runs the job right away instead.
+typedef struct ThreadPool {
+    pthread_t threads[THREAD_POOL_MAX_THREADS];
+    int threadCount;
+    bool quit;
+
+    ThreadPoolTask* head;
+    ThreadPoolTask* tail;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+} ThreadPool;
+
+int StartThreadPool(ThreadPool* pool, int threadCount);
+// Finishes the queued jobs, then joins the threads
+void StopThreadPool(ThreadPool* pool);
+int ThreadPoolSubmit(ThreadPool* pool, ThreadPoolJob job, void* argument);
+
+#endif
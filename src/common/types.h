@@ -1,6 +1,7 @@
 #ifndef TYPES_H
 #define TYPES_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 typedef struct Vector2 {
@@ -26,4 +27,22 @@ typedef struct Color{
     uint8_t alpha;
 } Color;
 
+// Characters that are not necessarily followed by a 0, like part of a bigger buffer
+typedef struct StringView {
+    const char* data;
+    size_t length;
+} StringView;
+
+// A string stored once in the intern table, 0 is no string
+typedef uint32_t StringId;
+
+// Refers to an element in a pooled slot. Slots are reused, the generation tells a handle to a removed element
+// apart from whatever lives in its slot now, so stale handles are caught instead of dangling.
+typedef struct ElementHandle {
+    uint32_t index;
+    uint32_t generation; // Never 0 for a live element
+} ElementHandle;
+
+#define NULL_ELEMENT ((ElementHandle){0, 0})
+
 #endif
\ No newline at end of file
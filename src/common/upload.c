@@ -0,0 +1,155 @@
+#include "upload.h"
+
+#include <glad/glad.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// glTexSubImage2D offsets stay aligned for any pixel format
+#define UPLOAD_ALIGNMENT 16
+
+int CreateUploadQueue(UploadQueue* queue) {
+    memset(queue, 0, sizeof(UploadQueue));
+
+    glGenBuffers(UPLOAD_BUFFER_COUNT, queue->buffers);
+    for (int i = 0; i < UPLOAD_BUFFER_COUNT; i++) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, queue->buffers[i]);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, UPLOAD_BUFFER_SIZE, NULL, GL_STREAM_DRAW);
+        queue->capacity[i] = UPLOAD_BUFFER_SIZE;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return 0;
+}
+
+void DestroyUploadQueue(UploadQueue* queue) {
+    FlushUploads(queue);
+
+    for (int i = 0; i < UPLOAD_BUFFER_COUNT; i++) {
+        if (queue->fences[i]) glDeleteSync(queue->fences[i]);
+    }
+    glDeleteBuffers(UPLOAD_BUFFER_COUNT, queue->buffers);
+    free(queue->requests);
+    memset(queue, 0, sizeof(UploadQueue));
+}
+
+// Maps the current buffer, waiting for the GPU only if it still reads uploads from its last round
+static int MapCurrent(UploadQueue* queue, size_t needed) {
+    int current = queue->current;
+
+    if (queue->fences[current]) {
+        GLenum status = glClientWaitSync(queue->fences[current], 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            queue->stalls++;
+            glClientWaitSync(queue->fences[current], GL_SYNC_FLUSH_COMMANDS_BIT, UINT64_MAX);
+        }
+        glDeleteSync(queue->fences[current]);
+        queue->fences[current] = NULL;
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, queue->buffers[current]);
+    if (needed > queue->capacity[current]) {
+        size_t capacity = queue->capacity[current];
+        while (capacity < needed) capacity *= 2;
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, capacity, NULL, GL_STREAM_DRAW);
+        queue->capacity[current] = capacity;
+    }
+
+    // Invalidating lets the driver hand out fresh memory instead of synchronizing
+    queue->mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, queue->capacity[current],
+                                     GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (queue->mapped == NULL) {
+        fprintf(stderr, "ERROR::UPLOAD::MAP_FAILED\n");
+        return 1;
+    }
+    queue->used = 0;
+    return 0;
+}
+
+static int ReserveRequest(UploadQueue* queue) {
+    if (queue->requestCount < queue->requestCapacity) return 0;
+
+    size_t capacity = queue->requestCapacity ? queue->requestCapacity * 2 : 64;
+    UploadRequest* requests = realloc(queue->requests, capacity * sizeof(UploadRequest));
+    if (requests == NULL) {
+        fprintf(stderr, "ERROR::UPLOAD::REQUEST_ALLOCATION_FAILED\n");
+        return 1;
+    }
+    queue->requests = requests;
+    queue->requestCapacity = capacity;
+    return 0;
+}
+
+int QueueTextureUpload(UploadQueue* queue, unsigned int texture, int x, int y, int width, int height,
+                       unsigned int format, int bytesPerPixel, const uint8_t* pixels, size_t pitch) {
+    if (width <= 0 || height <= 0) return 0;
+
+    size_t rowSize = (size_t)width * bytesPerPixel;
+    size_t size = rowSize * height;
+    size_t offset = (queue->used + UPLOAD_ALIGNMENT - 1) & ~(size_t)(UPLOAD_ALIGNMENT - 1);
+
+    if (queue->mapped && offset + size > queue->capacity[queue->current]) {
+        FlushUploads(queue);
+        offset = 0;
+    }
+    if (queue->mapped == NULL) {
+        if (MapCurrent(queue, size)) return 1;
+        offset = 0;
+    }
+
+    if (ReserveRequest(queue)) return 1;
+
+    for (int row = 0; row < height; row++) {
+        memcpy(queue->mapped + offset + row * rowSize, pixels + row * pitch, rowSize);
+    }
+
+    queue->requests[queue->requestCount++] = (UploadRequest){texture, x, y, width, height, format, offset, 0};
+    queue->used = offset + size;
+    return 0;
+}
+
+int QueueMipmapUpdate(UploadQueue* queue, unsigned int texture) {
+    // Without staged uploads the texture already holds its pixels
+    if (queue->mapped == NULL) {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return 0;
+    }
+
+    if (ReserveRequest(queue)) return 1;
+    queue->requests[queue->requestCount++] = (UploadRequest){.texture = texture, .mipmaps = 1};
+    return 0;
+}
+
+void FlushUploads(UploadQueue* queue) {
+    if (queue->mapped == NULL) return;
+
+    int current = queue->current;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, queue->buffers[current]);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    queue->mapped = NULL;
+
+    // Rows were staged tightly packed
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (size_t i = 0; i < queue->requestCount; i++) {
+        const UploadRequest* request = &queue->requests[i];
+        glBindTexture(GL_TEXTURE_2D, request->texture);
+        if (request->mipmaps) {
+            glGenerateMipmap(GL_TEXTURE_2D);
+            continue;
+        }
+        glTexSubImage2D(GL_TEXTURE_2D, 0, request->x, request->y, request->width, request->height,
+                        request->format, GL_UNSIGNED_BYTE, (const void*)request->offset);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    queue->fences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    queue->bytesUploaded += queue->used;
+    queue->requestCount = 0;
+    queue->used = 0;
+    queue->current = (current + 1) % UPLOAD_BUFFER_COUNT;
+}
@@ -0,0 +1,52 @@
+#ifndef UPLOAD_H
+#define UPLOAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Staging buffers cycled through, a buffer is only refilled once the GPU finished reading it
+#define UPLOAD_BUFFER_COUNT 3
+// Starting size of each staging buffer, uploads bigger than this grow it
+#define UPLOAD_BUFFER_SIZE (1024 * 1024)
+
+typedef struct UploadRequest {
+    unsigned int texture;
+    int x, y;
+    int width, height;
+    unsigned int format; // GL format of the pixels, like GL_RED or GL_RGBA
+    size_t offset;       // Into the staging buffer
+    int mipmaps;         // Regenerates the mipmaps of texture instead of uploading, set by QueueMipmapUpdate
+} UploadRequest;
+
+// Texture uploads staged in pixel buffer objects. Queuing only copies into mapped memory,
+// the glTexSubImage2D calls read from the buffer so the driver copies asynchronously instead of stalling the frame.
+// Buffer objects are shared like textures, so one queue serves every window. Only use it on the thread with a current context.
+typedef struct UploadQueue {
+    unsigned int buffers[UPLOAD_BUFFER_COUNT];
+    size_t capacity[UPLOAD_BUFFER_COUNT];
+    void* fences[UPLOAD_BUFFER_COUNT]; // Signaled once the GPU read the uploads of a buffer
+    int current;                       // Buffer being filled
+    size_t used;                       // Bytes staged in the current buffer
+    uint8_t* mapped;                   // The current buffer while it is mapped
+
+    UploadRequest* requests; // Staged in the current buffer, issued by FlushUploads
+    size_t requestCount;
+    size_t requestCapacity;
+
+    size_t bytesUploaded;
+    size_t stalls; // Times a buffer was still in use by the GPU when it came around again
+} UploadQueue;
+
+int CreateUploadQueue(UploadQueue* queue);
+void DestroyUploadQueue(UploadQueue* queue);
+
+// Stages width * height pixels of bytesPerPixel each, rows are pitch bytes apart in pixels.
+// The texture has to have storage already, for example from glTexImage2D with NULL data.
+int QueueTextureUpload(UploadQueue* queue, unsigned int texture, int x, int y, int width, int height,
+                       unsigned int format, int bytesPerPixel, const uint8_t* pixels, size_t pitch);
+// Regenerates the mipmaps of texture once the uploads queued before it are issued
+int QueueMipmapUpdate(UploadQueue* queue, unsigned int texture);
+// Issues every staged upload, call once per frame before drawing with the textures
+void FlushUploads(UploadQueue* queue);
+
+#endif
@@ -7,35 +7,216 @@
 #include "common/font.h"
 #include "common/shader.h"
 #include "common/elements.h"
+#include "common/elementstore.h"
+#include "common/elementpool.h"
+#include "common/stringtable.h"
+#include "common/description.h"
+#include "common/layoutfile.h"
+#include "common/drawlist.h"
+#include "common/headless.h"
+#include "common/softraster.h"
+#include "common/pipeline.h"
+#include "common/gputimer.h"
+#include "common/upload.h"
+#include "common/quadtree.h"
+#include "common/image.h"
+#include "common/threadpool.h"
+#include "common/atlas.h"
+#include "shaders/embedded_shaders.h"
 
+#include <stdatomic.h>
+#include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #define CHARACTER_LOAD_COUNT 128
 #define MAT4_SIZE 16
+#define SHADER_CACHE_DIRECTORY ".guilay_cache"
+#define BUTTON_CORNER_RADIUS 6.0f
+// Child lists at least this long are culled through the quadtree instead of testing every child
+#define SPATIAL_CULL_MIN_CHILDREN 64
+// Images no bigger than this on both sides share the image atlas, bigger ones get their own mipmapped texture
+#define IMAGE_ATLAS_MAX_SIDE 128
+#define IMAGE_ATLAS_SIZE 1024
+#define GLYPH_ATLAS_SIZE 512
+#define IMAGE_DECODE_THREADS 2
 
 // ----------- Structures -----------
 
+// What a reconciliation changed, decides how much of the window has to be redone
+typedef enum {
+    CHANGED_PAINT  = 1 << 0, // Colors, strings, images or scrolls, the layout still holds
+    CHANGED_LAYOUT = 1 << 1, // Sizes, every element is still where it was in the tree
+    CHANGED_TREE   = 1 << 2  // Elements were added, removed or moved
+} ReconcileChanges;
+
+// Scratch space of SubmitDescription, kept between submissions
+typedef struct Reconciler {
+    Element** previous; // The old child list being matched against
+    size_t previousCapacity;
+    Element** next;     // The child list being built
+    size_t nextCapacity;
+    uint32_t* keys;     // Positions in previous + 1 by key, linear probing, 0 is empty
+    size_t keyCapacity;
+    size_t keyMask;     // Buckets used by the current list - 1, short lists only clear a few
+    ReconcileStats stats;
+    int changes; // ReconcileChanges
+} Reconciler;
+
 struct Window {
     GLFWwindow* openglWindow;
-    Vector2i size;
+    HeadlessContext headless; // Only used by the headless backend
+    SoftFramebuffer software; // Only used by the software backend
+    WindowPresentCallback present;
+    void* presentUser;
+    Vector2i size;        // Framebuffer size in pixels
+    Vector2 contentScale; // Pixels per layout unit, above 1 on HiDPI monitors
+    Vector2 layoutSize;   // The size divided by the content scale, elements are laid out and drawn in these units
     Element** elements;
     size_t elementCount;
+    size_t elementCapacity;
+    Arena arena; // Elements built between BeginWindowArena and EndWindowArena
+    ElementPool pool; // Slots of spawned elements, guarded by treeLock
+    Description description; // Only touched by the thread describing the window
+    Reconciler reconciler;   // Guarded by treeLock
+    Color clearColor;
+
+    // Frames are built on a worker while the previous one is submitted, the tree lock keeps
+    // the worker and the app from touching the elements at the same time
+    FramePipeline pipeline;
+    pthread_mutex_t treeLock;
+    bool layoutValid; // Cleared when sizes, the tree or the layout size change, guarded by treeLock
+    ElementStorage storage;
+    ElementStore store; // The flat copy of the tree for ELEMENT_STORAGE_FLAT, guarded by treeLock
+    bool storeValid;    // Cleared when the tree changes, other changes are copied into the arrays in place
+    // Element bounds indexed for culling and hit testing, synced after every layout and guarded by treeLock.
+    // Every sync stamps the entries it reaches, the ones it missed belong to elements that left the tree.
+    Quadtree spatial;
+    uint32_t spatialStamp;
+    size_t spatialReached;
+    QuadtreeItem** visible; // Query results, nested sections use the space after their parent's results
+    size_t visibleCapacity;
+    DrawListStats stats; // Of the last submitted frame
+
+    // Per window GL state, vertex arrays can not be shared between contexts
+    unsigned int vertexArray;
+    unsigned int vertexBuffer;
+    float projection[MAT4_SIZE];
+    bool gpuTiming;
+    GpuTimer gpuTimer; // Created on the first timed frame, queries belong to this window's context
+
+    // Resize events only record the newest size, UpdateWindow applies it once per frame
+    bool resizePending;
+    Vector2i pendingSize;
+    Vector2 pendingScale;
+
+    // Render scheduling, see SetWindowRenderMode
+    RenderMode renderMode;
+    atomic_bool dirty;
+    atomic_uint treeVersion;    // Counts changes to what frames are built from
+    unsigned int requestedVersion; // treeVersion when the frame being built ahead was requested
+    double animateUntil;
+    double wakeAt;          // Time of a scheduled invalidation, 0 when there is none
+
+    // Process cpu time sampled for FrameStats
+    double sampleStart;
+    clock_t sampleCpuStart;
+    float cpuUsage;
+    size_t framesRendered;
 };
 
 struct Character {
-    unsigned int TextureID;  // ID handle of the glyph texture
+    unsigned int TextureID;  // The glyph atlas, 0 for glyphs without pixels
+    Rect       UV;         // Where the glyph is in the atlas
     Vector2i   Size;       // Size of glyph
     Vector2i   Bearing;    // Offset from baseline to left/top of glyph
     unsigned int Advance;    // Offset to advance to next glyph
 };
 
+typedef enum {
+    IMAGE_PENDING, // Queued on the decode pool
+    IMAGE_DECODED, // Pixels are waiting for the main thread to upload them
+    IMAGE_READY,   // texture and uv can be drawn
+    IMAGE_FAILED
+} ImageState;
+
+// A decoded file, shared by every image with the same path
+struct ImageResource {
+    char* path;
+    atomic_int state;
+    DecodedImage decoded; // Written by the decode job, freed once uploaded
+    unsigned int texture;
+    Rect uv;
+    struct ImageResource* next;
+};
+
+// A texture whose space is handed out by a packer, everything drawn from it can share one draw
+typedef struct TextureAtlas {
+    unsigned int texture; // Created with the first allocation
+    int channels;         // 1 for coverage, 4 for RGBA
+    AtlasPacker packer;
+} TextureAtlas;
+
 struct Character characters[CHARACTER_LOAD_COUNT];
-unsigned int VAO, VBO;
-Shader textShader;
+int fontAscender; // Distance from the top of a line to the baseline at scale 1
+// Shared by every window through context sharing, GuilayExit resets them so the next GuilayInit loads them again
+bool sharedAssetsLoaded;
+Shader uiShader;
+bool programsLinked; // The UI program linked and its uniforms were looked up, see ProgramsReady
+bool programsFailed; // The UI program did not link, reported once
+UploadQueue uploads; // Texture data waiting for the next frame, shared by every window
+GLint projectionLocation;
+GuilayBackend backend;
+// Every open window, the first one is the context the others share with
+Window** windows;
+size_t windowCount;
+// Glyph bitmaps and images for the software backend, indexed by texture id with 0 left empty for solid fills
+SoftTexture* softTextures;
+size_t softTextureCount;
+// Rasterizes the tile row bands the frame workers hand out, started once so frames never create threads
+ThreadPool rasterPool;
+bool rasterPoolStarted;
+// Images are decoded on the pool and turned into textures by whichever window updates next
+ThreadPool decodePool;
+bool decodePoolStarted;
+pthread_mutex_t imageLock = PTHREAD_MUTEX_INITIALIZER; // Guards imageResources, frame workers add to it
+struct ImageResource* imageResources;
+atomic_bool imagesDecoded;
+// Indexed by AtlasKind, shared by every window like all textures
+TextureAtlas atlases[ATLAS_COUNT];
+// Interned label strings, shared by every window. Texts keep views of the characters, which never move,
+// so frame workers never need the lock.
+StringTable strings;
+pthread_mutex_t stringLock = PTHREAD_MUTEX_INITIALIZER;
+
+void BuildFrame(DrawList* packet, void* user);
+void MakeWindowCurrent(Window* window);
+
+// Seconds on a monotonic-enough clock, works before and without glfwInit
+static double Now() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+}
 
 // ----------- Init / Exit -----------
 
 int GuilayInit() {
+    return GuilayInitBackend(GUILAY_BACKEND_WINDOWED);
+}
+
+int GuilayInitBackend(GuilayBackend newBackend) {
+    backend = newBackend;
+
+    if (backend == GUILAY_BACKEND_HEADLESS) return HeadlessInit();
+    if (backend == GUILAY_BACKEND_SOFTWARE) {
+        if (!rasterPoolStarted && SOFT_RASTER_THREADS > 1) {
+            StartThreadPool(&rasterPool, SOFT_RASTER_THREADS - 1);
+            rasterPoolStarted = true;
+        }
+        return 0;
+    }
 
     if(glfwInit() == GLFW_FALSE) return 1;
 
@@ -48,7 +229,56 @@ int GuilayInit() {
 }
 
 void GuilayExit() {
-    glfwTerminate();
+    // Buffer objects die with the last context, which still has to be current to delete them
+    if (sharedAssetsLoaded && backend != GUILAY_BACKEND_SOFTWARE && windowCount) {
+        MakeWindowCurrent(windows[0]);
+        DestroyUploadQueue(&uploads);
+        for (struct ImageResource* resource = imageResources; resource; resource = resource->next) {
+            if (resource->texture && resource->texture != atlases[ATLAS_IMAGES].texture) glDeleteTextures(1, &resource->texture);
+        }
+        for (int i = 0; i < ATLAS_COUNT; i++) {
+            if (atlases[i].texture) glDeleteTextures(1, &atlases[i].texture);
+        }
+        if (uiShader.ID) glDeleteProgram(uiShader.ID);
+    }
+
+    while (windowCount) DestroyWindow(windows[windowCount - 1]);
+    free(windows);
+    windows = NULL;
+
+    // Frame workers rasterize until their windows are gone
+    if (rasterPoolStarted) StopThreadPool(&rasterPool);
+    rasterPoolStarted = false;
+
+    // Frame workers read the resources until their windows are gone and decode jobs write them until the pool stops
+    if (decodePoolStarted) StopThreadPool(&decodePool);
+    decodePoolStarted = false;
+    while (imageResources) {
+        struct ImageResource* resource = imageResources;
+        imageResources = resource->next;
+        FreeDecodedImage(&resource->decoded);
+        free(resource->path);
+        free(resource);
+    }
+    for (int i = 0; i < ATLAS_COUNT; i++) AtlasPackerDestroy(&atlases[i].packer);
+    memset(atlases, 0, sizeof(atlases));
+    FreeStringTable(&strings);
+    memset(&uiShader, 0, sizeof(Shader));
+    programsLinked = false;
+    programsFailed = false;
+    sharedAssetsLoaded = false;
+
+    if (backend == GUILAY_BACKEND_HEADLESS) HeadlessExit();
+    else if (backend == GUILAY_BACKEND_SOFTWARE) {
+        for (size_t i = 0; i < softTextureCount; i++) {
+            free(softTextures[i].coverage);
+            free(softTextures[i].rgba);
+        }
+        free(softTextures);
+        softTextures = NULL;
+        softTextureCount = 0;
+    }
+    else glfwTerminate();
 }
 
 void create_ortho_matrix(float *M, 
@@ -90,12 +320,115 @@ void create_ortho_matrix(float *M,
     M[15] = 1.0f;
 }
 
-int LoadAssets(Window* window) {
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        fprintf(stderr, "Failed to initialize GLAD\n");
-        return -1;
+// ----------- Textures -----------
+
+// Appends a texture for the software backend and returns its id, or 0 when it could not be stored
+static unsigned int AddSoftTexture(SoftTexture texture) {
+    size_t count = softTextureCount ? softTextureCount : 1;
+    SoftTexture* grown = realloc(softTextures, (count + 1) * sizeof(SoftTexture));
+    if (grown == NULL) {
+        fprintf(stderr, "Error: Could not store a software texture.\n");
+        return 0;
+    }
+
+    softTextures = grown;
+    if (softTextureCount == 0) memset(&softTextures[0], 0, sizeof(SoftTexture));
+    softTextures[count] = texture;
+    softTextureCount = count + 1;
+    return (unsigned int)count;
+}
+
+// Creates an empty texture of 1 (coverage) or 4 (RGBA) channels.
+// Atlases start out cleared so filtering around their rectangles never picks up garbage.
+static unsigned int CreateTexture(int width, int height, int channels, bool mipmaps) {
+    if (backend == GUILAY_BACKEND_SOFTWARE) {
+        uint8_t* texels = calloc((size_t)width * height, (size_t)channels);
+        SoftTexture texture = {width, height, channels == 1 ? texels : NULL, channels == 1 ? NULL : texels};
+        if (texels == NULL) return 0;
+
+        unsigned int id = AddSoftTexture(texture);
+        if (id == 0) free(texels);
+        return id;
+    }
+
+    uint8_t* clear = mipmaps ? NULL : calloc((size_t)width * height, (size_t)channels);
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, channels == 1 ? GL_R8 : GL_RGBA8, width, height, 0,
+                 channels == 1 ? GL_RED : GL_RGBA, GL_UNSIGNED_BYTE, clear);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    free(clear);
+    return texture;
+}
+
+// Writes width * height texels with rows pitch bytes apart, through the upload queue for GL
+static void WriteTexture(unsigned int texture, int x, int y, int width, int height, int channels,
+                         const uint8_t* pixels, size_t pitch) {
+    size_t rowSize = (size_t)width * channels;
+
+    if (backend == GUILAY_BACKEND_SOFTWARE) {
+        SoftTexture* target = &softTextures[texture];
+        uint8_t* texels = channels == 1 ? target->coverage : target->rgba;
+        for (int row = 0; row < height; row++) {
+            memcpy(texels + ((size_t)(y + row) * target->width + x) * channels, pixels + row * pitch, rowSize);
+        }
+        return;
+    }
+
+    QueueTextureUpload(&uploads, texture, x, y, width, height, channels == 1 ? GL_RED : GL_RGBA, channels, pixels, pitch);
+}
+
+static int InitAtlas(AtlasKind kind, int size, int channels) {
+    atlases[kind].texture = 0;
+    atlases[kind].channels = channels;
+    // A texel of padding keeps linear filtering from bleeding neighbours in
+    return AtlasPackerInit(&atlases[kind].packer, size, size, 1);
+}
+
+// Reserves width * height texels of an atlas, creating its texture on first use. Returns 1 when they do not fit.
+static int AllocateFromAtlas(AtlasKind kind, int width, int height, AtlasRect* rect) {
+    TextureAtlas* atlas = &atlases[kind];
+    if (AtlasAllocate(&atlas->packer, width, height, rect)) return 1;
+
+    if (atlas->texture == 0) atlas->texture = CreateTexture(atlas->packer.width, atlas->packer.height, atlas->channels, false);
+    if (atlas->texture == 0) {
+        AtlasFree(&atlas->packer, *rect);
+        return 1;
+    }
+    return 0;
+}
+
+static Rect AtlasUV(AtlasKind kind, AtlasRect rect) {
+    const AtlasPacker* packer = &atlases[kind].packer;
+    return (Rect){
+        {(float)rect.x / packer->width, (float)rect.y / packer->height},
+        {(float)rect.width / packer->width, (float)rect.height / packer->height}
+    };
+}
+
+// Copies a glyph into the glyph atlas, returns the atlas texture or 0 for glyphs without pixels
+unsigned int CreateGlyphTexture(FT_Bitmap* bitmap, Rect* uv) {
+    if (bitmap->width == 0 || bitmap->rows == 0) return 0;
+
+    AtlasRect rect;
+    if (AllocateFromAtlas(ATLAS_GLYPHS, (int)bitmap->width, (int)bitmap->rows, &rect)) {
+        fprintf(stderr, "Error: The glyph atlas is full.\n");
+        return 0;
     }
 
+    unsigned int texture = atlases[ATLAS_GLYPHS].texture;
+    WriteTexture(texture, rect.x, rect.y, rect.width, rect.height, 1, bitmap->buffer, (size_t)bitmap->pitch);
+    *uv = AtlasUV(ATLAS_GLYPHS, rect);
+    return texture;
+}
+
+// Loads the glyphs of the font into characters
+int LoadFont() {
     FT_Library ft;
     int errorCode = FT_Init_FreeType(&ft);
     printf("FT first call said: %d\n",errorCode);
@@ -106,8 +439,7 @@ int LoadAssets(Window* window) {
     if (errorCode) return 1;
 
     FT_Set_Pixel_Sizes(face, 0, 48); 
-
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // disable byte-alignment restriction
+    fontAscender = face->size->metrics.ascender >> 6;
 
     printf("Bookmark\n");
     fflush(stdout);
@@ -119,29 +451,12 @@ int LoadAssets(Window* window) {
         {
             printf("Failed to load glyph: %d\n", c);
         }
-        // generate texture
-        unsigned int texture;
-        glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            GL_RED,
-            face->glyph->bitmap.width,
-            face->glyph->bitmap.rows,
-            0,
-            GL_RED,
-            GL_UNSIGNED_BYTE,
-            face->glyph->bitmap.buffer
-        );
-        // set texture options
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        Rect uv = {{0, 0}, {0, 0}};
+        unsigned int texture = CreateGlyphTexture(&face->glyph->bitmap, &uv);
         // now store character for later use
         Character character = {
-            texture, 
+            texture,
+            uv,
             (Vector2i) {face->glyph->bitmap.width, face->glyph->bitmap.rows},
             (Vector2i) {face->glyph->bitmap_left, face->glyph->bitmap_top},
             face->glyph->advance.x
@@ -155,34 +470,284 @@ int LoadAssets(Window* window) {
     printf("Bookmark\n");
     fflush(stdout);
 
+    return 0;
+}
+
+// Loads everything windows share, once for the first window
+int LoadSharedAssets() {
+    InitAtlas(ATLAS_GLYPHS, GLYPH_ATLAS_SIZE, 1);
+    InitAtlas(ATLAS_IMAGES, IMAGE_ATLAS_SIZE, 4);
+    if (backend == GUILAY_BACKEND_SOFTWARE) return LoadFont();
+
+    GLADloadproc loader = backend == GUILAY_BACKEND_HEADLESS ? HeadlessGetProcAddress : (GLADloadproc)glfwGetProcAddress;
+    if (!gladLoadGLLoader(loader)) {
+        fprintf(stderr, "Failed to initialize GLAD\n");
+        return -1;
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // disable byte-alignment restriction
+
+    CreateUploadQueue(&uploads);
+    if (LoadFont()) return 1;
+    FlushUploads(&uploads);
+
+    ShaderEnableBinaryCache(SHADER_CACHE_DIRECTORY, loader);
+    ShaderEnableParallelCompile(loader);
+    // Compiles in the background, windows show their clear color until ProgramsReady
+    ShaderBeginCompile(&uiShader, ui_vert, ui_frag);
+
+    return 0;
+}
+
+// Polls the programs started in LoadSharedAssets, uniforms are looked up once they are linked.
+// A program that failed to link is reported once, windows keep showing their clear color then.
+static bool ProgramsReady() {
+    if (programsLinked || backend == GUILAY_BACKEND_SOFTWARE) return true;
+    if (programsFailed || !ShaderPoll(&uiShader)) return false;
+    if (!uiShader.linked) {
+        fprintf(stderr, "Error: The UI program did not link, windows only show their clear color.\n");
+        programsFailed = true;
+        return false;
+    }
+
+    projectionLocation = glGetUniformLocation(uiShader.ID, "projection");
+    if (projectionLocation == -1) {
+        fprintf(stderr, "Failed to find uniform!\n");
+    }
+    programsLinked = true;
+    return true;
+}
+
+// Top left origin in layout units so layout and draw commands share one coordinate space,
+// the viewport maps them onto the framebuffer pixels
+static void UpdateProjection(Window* window) {
+    create_ortho_matrix(window->projection, 0.0f, window->layoutSize.x, window->layoutSize.y, 0.0f, -1.0f, 1.0f);
+    if (backend != GUILAY_BACKEND_SOFTWARE) glViewport(0, 0, window->size.x, window->size.y);
+}
+
+int LoadAssets(Window* window) {
+    if (!sharedAssetsLoaded) {
+        int errorCode = LoadSharedAssets();
+        if (errorCode) return errorCode;
+        sharedAssetsLoaded = true;
+    }
+
+    if (backend == GUILAY_BACKEND_SOFTWARE) return 0;
+
+    MakeWindowCurrent(window);
+
+    // Framebuffers and vertex arrays are container objects, which contexts never share
+    if (backend == GUILAY_BACKEND_HEADLESS && HeadlessCreateFramebuffer(&window->headless)) return -1;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);  
 
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
+    glGenVertexArrays(1, &window->vertexArray);
+    glGenBuffers(1, &window->vertexBuffer);
+    glBindVertexArray(window->vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, window->vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(DrawVertex) * 6, NULL, GL_DYNAMIC_DRAW);
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(DrawVertex), 0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, sizeof(DrawVertex), (void*)offsetof(DrawVertex, kind));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(DrawVertex), (void*)offsetof(DrawVertex, shape));
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(DrawVertex), (void*)offsetof(DrawVertex, color));
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0); 
-    
-    CreateShader(&textShader, "src/shaders/fontShader.vert", "src/shaders/fontShader.frag");
 
-    float projection[MAT4_SIZE];
+    UpdateProjection(window);
+
+    return 0;
+}
 
-    create_ortho_matrix(projection,0.0f,(float)window->size.x,0.0f,(float)window->size.y,-1.0f,1.0f);
+// ----------- Images -----------
 
-    GLint colorUniformLocation = glGetUniformLocation(textShader.ID, "projection");
-    if (colorUniformLocation == -1) {
-        fprintf(stderr, "Failed to find uniform!\n");
+static void DecodeImageJob(void* argument) {
+    struct ImageResource* resource = argument;
+
+    if (DecodeImage(resource->path, &resource->decoded)) {
+        atomic_store(&resource->state, IMAGE_FAILED);
+        return;
     }
+    atomic_store(&resource->state, IMAGE_DECODED);
+    atomic_store(&imagesDecoded, true);
+    // Wakes on demand windows sleeping in glfwWaitEvents
+    if (backend == GUILAY_BACKEND_WINDOWED) glfwPostEmptyEvent();
+}
 
-    glUseProgram(textShader.ID);
-    glUniformMatrix4fv(colorUniformLocation, 1, GL_FALSE, projection);
+// Finds the resource of path or queues its file for decoding, can be called from frame workers
+static struct ImageResource* RequestImage(const char* path) {
+    if (path == NULL) return NULL;
 
-    return 0;
+    pthread_mutex_lock(&imageLock);
+    struct ImageResource* resource = imageResources;
+    while (resource && strcmp(resource->path, path)) resource = resource->next;
+
+    if (resource == NULL) {
+        resource = calloc(1, sizeof(struct ImageResource));
+        if (resource) resource->path = strdup(path);
+        if (resource && resource->path) {
+            atomic_init(&resource->state, IMAGE_PENDING);
+            resource->next = imageResources;
+            imageResources = resource;
+
+            if (!decodePoolStarted) {
+                StartThreadPool(&decodePool, IMAGE_DECODE_THREADS);
+                decodePoolStarted = true;
+            }
+            if (ThreadPoolSubmit(&decodePool, DecodeImageJob, resource)) atomic_store(&resource->state, IMAGE_FAILED);
+        } else {
+            fprintf(stderr, "Error: Could not track the image %s.\n", path);
+            free(resource);
+            resource = NULL;
+        }
+    }
+    pthread_mutex_unlock(&imageLock);
+    return resource;
+}
+
+// Returns false when the image does not fit in what is left of the atlas
+static bool PlaceInAtlas(struct ImageResource* resource) {
+    const DecodedImage* image = &resource->decoded;
+
+    AtlasRect rect;
+    if (AllocateFromAtlas(ATLAS_IMAGES, image->width, image->height, &rect)) return false;
+
+    resource->texture = atlases[ATLAS_IMAGES].texture;
+    resource->uv = AtlasUV(ATLAS_IMAGES, rect);
+    WriteTexture(resource->texture, rect.x, rect.y, rect.width, rect.height, 4, image->pixels, (size_t)image->width * 4);
+    return true;
+}
+
+static bool UploadImage(struct ImageResource* resource) {
+    const DecodedImage* image = &resource->decoded;
+    if (image->width <= IMAGE_ATLAS_MAX_SIDE && image->height <= IMAGE_ATLAS_MAX_SIDE && PlaceInAtlas(resource)) return true;
+
+    // Large images are often drawn scaled down, mipmaps keep that from shimmering
+    resource->texture = CreateTexture(image->width, image->height, 4, true);
+    if (resource->texture == 0) return false;
+    WriteTexture(resource->texture, 0, 0, image->width, image->height, 4, image->pixels, (size_t)image->width * 4);
+    if (backend != GUILAY_BACKEND_SOFTWARE) QueueMipmapUpdate(&uploads, resource->texture);
+    resource->uv = (Rect){{0, 0}, {1, 1}};
+    return true;
+}
+
+// Turns every image decoded since the last call into a texture, needs a current context.
+// Returns true when any image changed state, windows have to redraw to show it then.
+static bool UploadDecodedImages() {
+    if (!atomic_exchange(&imagesDecoded, false)) return false;
+
+    pthread_mutex_lock(&imageLock);
+    for (struct ImageResource* resource = imageResources; resource; resource = resource->next) {
+        if (atomic_load(&resource->state) != IMAGE_DECODED) continue;
+
+        bool uploaded = UploadImage(resource);
+        FreeDecodedImage(&resource->decoded);
+        atomic_store(&resource->state, uploaded ? IMAGE_READY : IMAGE_FAILED);
+    }
+    pthread_mutex_unlock(&imageLock);
+    return true;
+}
+
+// ----------- Input callbacks -----------
+
+static void MarkDirty(GLFWwindow* openglWindow) {
+    Window* window = glfwGetWindowUserPointer(openglWindow);
+    if (window) atomic_store(&window->dirty, true);
+}
+
+static void OnWindowRefresh(GLFWwindow* w) { MarkDirty(w); }
+
+static void OnCursorPos(GLFWwindow* w, double x, double y) {
+    (void)x;
+    (void)y;
+    MarkDirty(w);
+}
+
+static void OnMouseButton(GLFWwindow* w, int button, int action, int mods) {
+    (void)button;
+    (void)action;
+    (void)mods;
+    MarkDirty(w);
+}
+
+static void OnScroll(GLFWwindow* w, double x, double y) {
+    (void)x;
+    (void)y;
+    MarkDirty(w);
+}
+
+static void OnKey(GLFWwindow* w, int key, int scancode, int action, int mods) {
+    (void)key;
+    (void)scancode;
+    (void)action;
+    (void)mods;
+    MarkDirty(w);
+}
+
+static void OnChar(GLFWwindow* w, unsigned int codepoint) {
+    (void)codepoint;
+    MarkDirty(w);
+}
+
+static void OnFocus(GLFWwindow* w, int focused) {
+    (void)focused;
+    MarkDirty(w);
+}
+
+static void RequestResize(Window* window, Vector2i size, Vector2 scale) {
+    window->pendingSize = size;
+    window->pendingScale = scale;
+    window->resizePending = true;
+    atomic_store(&window->dirty, true);
+}
+
+// Dragging a window edge fires these many times per frame, only the last values are kept
+static void OnFramebufferSize(GLFWwindow* w, int width, int height) {
+    Window* window = glfwGetWindowUserPointer(w);
+    RequestResize(window, (Vector2i){width, height}, window->pendingScale);
+}
+
+static void OnContentScale(GLFWwindow* w, float x, float y) {
+    Window* window = glfwGetWindowUserPointer(w);
+    RequestResize(window, window->pendingSize, (Vector2){x, y});
+}
+
+// Returns true when the size or scale changed, the frame in flight was built for the old one then
+static bool ApplyPendingResize(Window* window) {
+    if (!window->resizePending) return false;
+    window->resizePending = false;
+
+    Vector2i size = window->pendingSize;
+    Vector2 scale = window->pendingScale;
+    // Minimized windows report a zero framebuffer, keep the old one until they come back
+    if (size.x <= 0 || size.y <= 0 || scale.x <= 0 || scale.y <= 0) return false;
+
+    bool sizeChanged = size.x != window->size.x || size.y != window->size.y;
+    if (!sizeChanged && scale.x == window->contentScale.x && scale.y == window->contentScale.y) return false;
+
+    MakeWindowCurrent(window);
+    if (sizeChanged && backend == GUILAY_BACKEND_SOFTWARE && SoftResizeFramebuffer(&window->software, size)) return false;
+    if (sizeChanged && backend == GUILAY_BACKEND_HEADLESS) HeadlessResizeFramebuffer(&window->headless, size);
+
+    Vector2 layoutSize = {size.x / scale.x, size.y / scale.y};
+
+    pthread_mutex_lock(&window->treeLock);
+    window->size = size;
+    window->contentScale = scale;
+    // Only the layout size matters to elements, a scale change that cancels a size change keeps the layout
+    if (layoutSize.x != window->layoutSize.x || layoutSize.y != window->layoutSize.y) {
+        window->layoutSize = layoutSize;
+        window->layoutValid = false;
+    }
+    pthread_mutex_unlock(&window->treeLock);
+
+    UpdateProjection(window);
+    return true;
 }
 
 // ----------- Window creation -----------
@@ -190,16 +755,163 @@ int LoadAssets(Window* window) {
 Window *CreateWindow(Vector2i size, char* name) {
     Window *window = (Window*)malloc(sizeof(Window));
     window->size = size;
-
-    window->openglWindow = glfwCreateWindow(size.x, size.y, name, NULL, NULL);
+    window->contentScale = (Vector2){1, 1};
+    window->gpuTiming = false;
+    QuadtreeInit(&window->spatial, (Rect){{0, 0}, {(float)size.x, (float)size.y}});
+    window->visible = NULL;
+    window->visibleCapacity = 0;
+    window->gpuTimer.ready = false;
+    window->resizePending = false;
+    window->layoutValid = false;
+    window->storage = ELEMENT_STORAGE_TREE;
+    InitElementStore(&window->store);
+    window->storeValid = false;
+    window->spatialStamp = 0;
+    window->spatialReached = 0;
+    window->openglWindow = NULL;
     window->elementCount = 0;
+    window->elementCapacity = 0;
     window->elements = NULL;
+    ArenaInit(&window->arena);
+    InitElementPool(&window->pool);
+    InitDescription(&window->description);
+    memset(&window->reconciler, 0, sizeof(Reconciler));
+    window->present = NULL;
+    window->presentUser = NULL;
+    memset(&window->stats, 0, sizeof(DrawListStats));
+    window->clearColor = (Color){0, 0, 0, 255};
+    window->renderMode = RENDER_CONTINUOUS;
+    atomic_init(&window->dirty, true);
+    atomic_init(&window->treeVersion, 0);
+    window->requestedVersion = 0;
+    window->animateUntil = 0;
+    window->wakeAt = 0;
+    window->sampleStart = Now();
+    window->sampleCpuStart = clock();
+    window->cpuUsage = 0;
+    window->framesRendered = 0;
+
+    if (backend == GUILAY_BACKEND_SOFTWARE) {
+        if (SoftCreateFramebuffer(&window->software, size)) {
+            free(window);
+            return NULL;
+        }
+    } else if (backend == GUILAY_BACKEND_HEADLESS) {
+        if (HeadlessCreateContext(&window->headless, size, windowCount ? &windows[0]->headless : NULL)) {
+            free(window);
+            return NULL;
+        }
+    } else {
+        // Sharing with the first window gives every window the same textures and programs
+        window->openglWindow = glfwCreateWindow(size.x, size.y, name, NULL, windowCount ? windows[0]->openglWindow : NULL);
+        if (!window->openglWindow) {
+            free(window);
+            return NULL;
+        }
+
+        glfwMakeContextCurrent(window->openglWindow);
+
+        // Any input may change what the app wants shown, so it all counts as an invalidation
+        glfwSetWindowUserPointer(window->openglWindow, window);
+        glfwSetWindowRefreshCallback(window->openglWindow, OnWindowRefresh);
+        glfwSetCursorPosCallback(window->openglWindow, OnCursorPos);
+        glfwSetMouseButtonCallback(window->openglWindow, OnMouseButton);
+        glfwSetScrollCallback(window->openglWindow, OnScroll);
+        glfwSetKeyCallback(window->openglWindow, OnKey);
+        glfwSetCharCallback(window->openglWindow, OnChar);
+        glfwSetWindowFocusCallback(window->openglWindow, OnFocus);
+        glfwSetFramebufferSizeCallback(window->openglWindow, OnFramebufferSize);
+        glfwSetWindowContentScaleCallback(window->openglWindow, OnContentScale);
+
+        // On HiDPI screens the framebuffer is bigger than the requested size
+        glfwGetFramebufferSize(window->openglWindow, &window->size.x, &window->size.y);
+        glfwGetWindowContentScale(window->openglWindow, &window->contentScale.x, &window->contentScale.y);
+        if (window->size.x <= 0 || window->size.y <= 0) window->size = size;
+        if (window->contentScale.x <= 0 || window->contentScale.y <= 0) window->contentScale = (Vector2){1, 1};
+    }
+
+    window->layoutSize = (Vector2){window->size.x / window->contentScale.x, window->size.y / window->contentScale.y};
+    window->pendingSize = window->size;
+    window->pendingScale = window->contentScale;
+
+    Window** temp = realloc(windows, (windowCount + 1) * sizeof(Window*));
+    if (temp == NULL) {
+        fprintf(stderr, "Error: Could not register the window.\n");
+        if (backend == GUILAY_BACKEND_SOFTWARE) SoftDestroyFramebuffer(&window->software);
+        else if (backend == GUILAY_BACKEND_HEADLESS) HeadlessDestroyContext(&window->headless);
+        else glfwDestroyWindow(window->openglWindow);
+        free(window);
+        return NULL;
+    }
+    windows = temp;
+    windows[windowCount++] = window;
 
-    glfwMakeContextCurrent(window->openglWindow);
+    window->vertexArray = 0;
+    window->vertexBuffer = 0;
+    pthread_mutex_init(&window->treeLock, NULL);
+    StartFramePipeline(&window->pipeline, BuildFrame, window);
 
     return window;
 }
 
+void MakeWindowCurrent(Window* window) {
+    if (backend == GUILAY_BACKEND_HEADLESS) HeadlessMakeCurrent(&window->headless);
+    else if (backend == GUILAY_BACKEND_WINDOWED && glfwGetCurrentContext() != window->openglWindow) {
+        glfwMakeContextCurrent(window->openglWindow);
+    }
+}
+
+// Forgets the window's index entries so the elements can be shown by another window
+static void ClearSpatialIndex(Element** elements, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        elements[i]->spatial = NULL;
+        if (elements[i]->type == SECTION) {
+            Section* section = elements[i]->data;
+            ClearSpatialIndex(section->children, section->childrenCount);
+        }
+    }
+}
+
+void DestroyWindow(Window* window) {
+    StopFramePipeline(&window->pipeline);
+    pthread_mutex_destroy(&window->treeLock);
+
+    if (backend == GUILAY_BACKEND_SOFTWARE) {
+        SoftDestroyFramebuffer(&window->software);
+    } else {
+        if (sharedAssetsLoaded) {
+            MakeWindowCurrent(window);
+            GpuTimerDestroy(&window->gpuTimer);
+            glDeleteVertexArrays(1, &window->vertexArray);
+            glDeleteBuffers(1, &window->vertexBuffer);
+        }
+        // Shared objects live on as long as any context of the share group does
+        if (backend == GUILAY_BACKEND_HEADLESS) HeadlessDestroyContext(&window->headless);
+        else glfwDestroyWindow(window->openglWindow);
+    }
+
+    for (size_t i = 0; i < windowCount; i++) {
+        if (windows[i] != window) continue;
+        memmove(windows + i, windows + i + 1, (windowCount - i - 1) * sizeof(Window*));
+        windowCount--;
+        break;
+    }
+
+    ClearSpatialIndex(window->elements, window->elementCount);
+    QuadtreeDestroy(&window->spatial);
+    FreeElementStore(&window->store);
+    if (GetElementArena() == &window->arena) SetElementArena(NULL);
+    ArenaDestroy(&window->arena);
+    FreeElementPool(&window->pool);
+    FreeDescription(&window->description);
+    free(window->reconciler.previous);
+    free(window->reconciler.next);
+    free(window->reconciler.keys);
+    free(window->visible);
+    free(window->elements);
+    free(window);
+}
+
 
 // ----------- Projection setup -----------
 
@@ -207,6 +919,19 @@ Window *CreateWindow(Vector2i size, char* name) {
 // ----------- Clear -----------
 
 void FillWindow(Window* window, Color fillColor) {
+    // The clear itself happens when a frame is rendered, so skipped frames cost nothing
+    if (memcmp(&window->clearColor, &fillColor, sizeof(Color))) atomic_store(&window->dirty, true);
+    window->clearColor = fillColor;
+}
+
+void ClearFrame(Window* window) {
+    Color fillColor = window->clearColor;
+
+    if (backend == GUILAY_BACKEND_SOFTWARE) {
+        SoftClear(&window->software, fillColor);
+        return;
+    }
+
     glClearColor(fillColor.red / 255.0f,
                  fillColor.green / 255.0f,
                  fillColor.blue / 255.0f,
@@ -216,74 +941,1308 @@ void FillWindow(Window* window, Color fillColor) {
 }
 
 
-// ----------- Text Rendering (compatibility mode) -----------
+// ----------- Frame building -----------
 
-void RenderText(Shader *s, char* text, float x, float y, float scale, Color color)
+void BuildText(DrawList* list, Shader *s, Text* text, Rect bounds)
 {
-    // activate corresponding render state	
-    ShaderUse(s);
-    glUniform3f(glGetUniformLocation(s->ID, "textColor"), color.red/255, color.green/255, color.blue/255);
-    glActiveTexture(GL_TEXTURE0);
-    glBindVertexArray(VAO);
+    float scale = text->scale;
+    float x = bounds.position.x;
+    float baseline = bounds.position.y + fontAscender * scale;
 
     // iterate through all characters
-    for (int i = 0; i < strlen(text); i++)
+    for (size_t i = 0; i < text->length; i++)
     {
-        Character ch = characters[text[i]];
+        unsigned char c = (unsigned char)text->text[i];
+        if (c >= CHARACTER_LOAD_COUNT) continue;
+        Character ch = characters[c];
 
         float xpos = x + ch.Bearing.x * scale;
-        float ypos = y - (ch.Size.y - ch.Bearing.y) * scale;
+        float ypos = baseline - ch.Bearing.y * scale;
 
         float w = ch.Size.x * scale;
         float h = ch.Size.y * scale;
-        // update VBO for each character
-        float vertices[6][4] = {
-            { xpos,     ypos + h,   0.0f, 0.0f },            
-            { xpos,     ypos,       0.0f, 1.0f },
-            { xpos + w, ypos,       1.0f, 1.0f },
-
-            { xpos,     ypos + h,   0.0f, 0.0f },
-            { xpos + w, ypos,       1.0f, 1.0f },
-            { xpos + w, ypos + h,   1.0f, 0.0f }           
-        };
-        // render glyph texture over quad
-        glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-        // update content of VBO memory
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices); 
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        // render quad
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+
+        if (w > 0 && h > 0 && ch.TextureID) {
+            DrawCommand command = {
+                .layer = DRAW_LAYER_CONTENT,
+                .program = s->ID,
+                .texture = ch.TextureID,
+                .blend = DRAW_BLEND_ALPHA,
+                .color = text->color,
+                .bounds = {{xpos, ypos}, {w, h}}
+            };
+            PushDrawQuad(list, &command, DRAW_KIND_GLYPH, command.bounds, ch.UV);
+        }
         // now advance cursors for next glyph (note that advance is number of 1/64 pixels)
         x += (ch.Advance >> 6) * scale; // bitshift by 6 to get value in pixels (2^6 = 64)
     }
-    glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glUseProgram(0)
 }
 
+// Images that are not decoded yet are skipped, the window redraws once they are ready
+void BuildImage(DrawList* list, Shader *s, Image* image, Rect bounds) {
+    // Images added inside of sections only start decoding when they are first reached
+    if (image->resource == NULL) image->resource = RequestImage(image->path);
 
-// ----------- Update Window -----------
+    struct ImageResource* resource = image->resource;
+    if (resource == NULL || atomic_load(&resource->state) != IMAGE_READY || image->tint.alpha == 0) return;
 
-void UpdateWindow(Window* window) {
-    for (size_t i = 0; i < window->elementCount; i++) {
-        Element* element = window->elements[i];
+    DrawCommand command = {
+        .layer = DRAW_LAYER_CONTENT,
+        .program = s->ID,
+        .texture = resource->texture,
+        .blend = DRAW_BLEND_ALPHA,
+        .color = image->tint,
+        .bounds = bounds
+    };
+    PushDrawQuad(list, &command, DRAW_KIND_IMAGE, bounds, resource->uv);
+}
+
+// Fills bounds with color on the background layer, nothing is recorded for transparent colors
+void BuildBackground(DrawList* list, Shader *s, Rect bounds, Color color, float radius) {
+    if (color.alpha == 0 || bounds.size.x <= 0 || bounds.size.y <= 0) return;
+
+    DrawCommand command = {
+        .layer = DRAW_LAYER_BACKGROUND,
+        .program = s->ID,
+        .blend = DRAW_BLEND_ALPHA,
+        .color = color,
+        .bounds = bounds
+    };
+    if (radius > 0) PushDrawRoundedRect(list, &command, bounds, radius);
+    else PushDrawQuad(list, &command, DRAW_KIND_SOLID, bounds, (Rect){{0, 0}, {0, 0}});
+}
+
+void BuildChildren(Window* window, DrawList* list, const void* parent, Element** elements, size_t count,
+                   Vector2 offset, size_t base);
+
+// Where bounds end up once the scrolls of the sections around them, adding up to offset, are applied
+static Rect Scrolled(Rect bounds, Vector2 offset) {
+    bounds.position.x -= offset.x;
+    bounds.position.y -= offset.y;
+    return bounds;
+}
+
+// offset is what the scrolls of the sections around element add up to, sections add their own for their children
+void BuildElement(Window* window, DrawList* list, Element* element, Vector2 offset, size_t base) {
+    Rect bounds = Scrolled(element->bounds, offset);
+
+    if (element->type == TEXT) {
+        BuildText(list, &uiShader, element->data, bounds);
+    } else if (element->type == SECTION) {
+        Section* section = element->data;
+        BuildBackground(list, &uiShader, bounds, section->color, 0);
+        PushDrawClip(list, bounds);
+        Vector2 inner = {offset.x + section->scroll.x, offset.y + section->scroll.y};
+        BuildChildren(window, list, section, section->children, section->childrenCount, inner, base);
+        PopDrawClip(list);
+    } else if (element->type == BUTTON) {
+        Button* button = element->data;
+        BuildBackground(list, &uiShader, bounds, button->color, BUTTON_CORNER_RADIUS);
+        if (button->text) BuildText(list, &uiShader, button->text, bounds);
+    } else if (element->type == IMAGE) {
+        BuildImage(list, &uiShader, element->data, bounds);
+    }
+}
+
+static int CompareItemOrder(const void* a, const void* b) {
+    size_t first = (*(QuadtreeItem* const*)a)->order;
+    size_t second = (*(QuadtreeItem* const*)b)->order;
+    return first < second ? -1 : (first > second);
+}
+
+// Asks the quadtree for the children inside of the clip and puts them back in painter order,
+// results go to window->visible from base on. Returns false when the results did not fit.
+static bool BuildVisibleChildren(Window* window, DrawList* list, const void* parent, size_t count, Vector2 offset,
+                                 size_t base) {
+    // The index holds unscrolled bounds, so the clip is moved by the scroll instead of every child
+    Rect range = GetDrawClip(list);
+    range.position.x += offset.x;
+    range.position.y += offset.y;
+    QuadtreeItem** results = window->visible + base;
+    size_t space = window->visibleCapacity - base;
+    size_t found = QuadtreeQueryRange(&window->spatial, range, results, space);
+
+    if (found > space) {
+        size_t capacity = window->visibleCapacity ? window->visibleCapacity : 256;
+        while (capacity < base + found) capacity *= 2;
+        QuadtreeItem** visible = realloc(window->visible, capacity * sizeof(QuadtreeItem*));
+        if (visible == NULL) return false;
+        window->visible = visible;
+        window->visibleCapacity = capacity;
+
+        results = window->visible + base;
+        found = QuadtreeQueryRange(&window->spatial, range, results, capacity - base);
+    }
+
+    // Descendants of the children overlap the clip as well, only the direct children are drawn here
+    size_t kept = 0;
+    for (size_t i = 0; i < found; i++) {
+        if (results[i]->parent == parent) results[kept++] = results[i];
+    }
+    qsort(results, kept, sizeof(QuadtreeItem*), CompareItemOrder);
 
-        if (element->type == TEXT) {
-            Text* t = element->data;
-            RenderText(&textShader, t->text, 20, window->size.y - 40, t->scale, (Color){255,255,255});
+    list->stats.culled += count - kept;
+    // Nested sections may grow window->visible, so results is not used past this point
+    for (size_t i = 0; i < kept; i++) {
+        BuildElement(window, list, window->visible[base + i]->element, offset, base + kept);
+    }
+    return true;
+}
+
+// Walks the tree with the clip of the enclosing sections, anything outside of it is skipped with its whole subtree.
+// Long child lists, like a scrolled list, are culled with the quadtree so only the visible part is touched.
+void BuildChildren(Window* window, DrawList* list, const void* parent, Element** elements, size_t count,
+                   Vector2 offset, size_t base) {
+    if (count >= SPATIAL_CULL_MIN_CHILDREN && BuildVisibleChildren(window, list, parent, count, offset, base)) return;
+
+    for (size_t i = 0; i < count; i++) {
+        Element* element = elements[i];
+
+        if (!DrawClipVisible(list, Scrolled(element->bounds, offset))) {
+            list->stats.culled++;
+            continue;
         }
+        BuildElement(window, list, element, offset, base);
     }
+}
 
-    glfwSwapBuffers(window->openglWindow);
-    glfwPollEvents();
+// Brings the index entry of an element in the tree up to date and stamps it with the running sync.
+// Only entries whose bounds changed are moved.
+static void SyncSpatialEntry(Window* window, Element* element, const void* parent, size_t order) {
+    QuadtreeItem* item = element->spatial;
+    // An element that left the tree and came back may point at an entry that was pruned and handed out again
+    if (item && item->element != element) item = NULL;
+
+    if (item == NULL) item = QuadtreeInsert(&window->spatial, element, element->bounds);
+    else if (memcmp(&item->bounds, &element->bounds, sizeof(Rect)) != 0) {
+        QuadtreeMove(&window->spatial, item, element->bounds);
+    }
+    element->spatial = item;
+    if (item == NULL) return;
+
+    item->parent = parent;
+    item->order = order;
+    item->stamp = window->spatialStamp;
+    window->spatialReached++;
 }
 
-bool WindowShouldClose(Window* window) {
-    return glfwWindowShouldClose(window->openglWindow);
+// Keeps the quadtree in step with the bounds LayoutElements just wrote, numbering elements in pre-order
+static void SyncSpatialIndex(Window* window, const void* parent, Element** elements, size_t count, size_t* order) {
+    for (size_t i = 0; i < count; i++) {
+        Element* element = elements[i];
+        SyncSpatialEntry(window, element, parent, (*order)++);
+
+        if (element->type == SECTION) {
+            Section* section = element->data;
+            SyncSpatialIndex(window, section, section->children, section->childrenCount, order);
+        }
+    }
 }
 
-void AddElement(Window* window, Element* element) {
-    ResizeElementsArray(window->elements, &window->elementCount, window->elementCount + 1);
-    window->elements[window->elementCount - 1] = element;
+// Same as SyncSpatialIndex for the flat copy of the tree, whose pre-order positions are the indices
+static void SyncStoredSpatialIndex(Window* window) {
+    const ElementStore* store = &window->store;
+
+    for (size_t i = 0; i < store->count; i++) {
+        Element* element = store->sources[i];
+        element->bounds = store->bounds[i];
+        uint32_t parent = store->parents[i];
+        SyncSpatialEntry(window, element, parent == ELEMENT_NONE ? NULL : store->sources[parent]->data, i);
+    }
+}
+
+// Draws the flat copy of the tree in one pass. A stack of open sections replaces the recursion,
+// subtrees outside of the clip are skipped by jumping to their end.
+static void BuildStoredElements(DrawList* list, ElementStore* store) {
+    size_t depth = 0;
+
+    for (size_t i = 0; i < store->count;) {
+        while (depth && i >= store->openEnds[depth - 1]) {
+            PopDrawClip(list);
+            depth--;
+        }
+
+        Vector2 offset = depth ? store->openScrolls[depth - 1] : (Vector2){0, 0};
+        Rect bounds = Scrolled(store->bounds[i], offset);
+        if (!DrawClipVisible(list, bounds)) {
+            list->stats.culled++;
+            i = store->ends[i];
+            continue;
+        }
+
+        RefreshElementPaint(store, (uint32_t)i);
+        uint8_t type = store->types[i];
+        if (store->flags[i] & ELEMENT_FLAG_FILL) {
+            BuildBackground(list, &uiShader, bounds, store->colors[i], type == BUTTON ? BUTTON_CORNER_RADIUS : 0);
+        }
+        if (store->texts[i]) BuildText(list, &uiShader, store->texts[i], bounds);
+        if (type == IMAGE) BuildImage(list, &uiShader, store->sources[i]->data, bounds);
+
+        if (store->flags[i] & ELEMENT_FLAG_CLIPS) {
+            // Scrolls are read from the sections, so scrolling never touches the arrays
+            Vector2 scroll = ((Section*)store->sources[i]->data)->scroll;
+            PushDrawClip(list, bounds);
+            store->openEnds[depth] = store->ends[i];
+            store->openScrolls[depth++] = (Vector2){offset.x + scroll.x, offset.y + scroll.y};
+        }
+        i++;
+    }
+
+    while (depth--) PopDrawClip(list);
+}
+
+// Lays out the window and records its draw commands in tree order, then sorts them.
+// Runs on the frame worker.
+void BuildFrame(DrawList* packet, void* user) {
+    Window* window = user;
+
+    pthread_mutex_lock(&window->treeLock);
+    Rect area = {{0, 0}, window->layoutSize};
+
+    // Falls back to the tree for this frame when the copy does not fit in memory
+    bool flat = window->storage == ELEMENT_STORAGE_FLAT &&
+                (window->storeValid || FlattenElements(&window->store, window->elements, window->elementCount) == 0);
+    bool flattened = flat && !window->storeValid;
+    if (flattened) {
+        window->storeValid = true;
+        window->layoutValid = false;
+    }
+
+    // Redraws of an unchanged layout, like input, new colors or scrolling, reuse the last layout and index
+    if (!window->layoutValid) {
+        window->spatialStamp++;
+        window->spatialReached = 0;
+        size_t order = 0;
+        if (flat) {
+            // Sizes changed where they are, the structure still holds
+            if (!flattened) RefreshElementSizes(&window->store);
+            LayoutElementStore(&window->store, area);
+            SyncStoredSpatialIndex(window);
+        } else {
+            LayoutElements(window->elements, window->elementCount, area);
+            SyncSpatialIndex(window, NULL, window->elements, window->elementCount, &order);
+        }
+        // Entries the sync did not reach belong to elements taken out of the tree by hand
+        if (window->spatial.count != window->spatialReached) {
+            QuadtreeRemoveUnstamped(&window->spatial, window->spatialStamp);
+        }
+        window->layoutValid = true;
+    }
+
+    PushDrawClip(packet, area);
+    if (flat) BuildStoredElements(packet, &window->store);
+    else BuildChildren(window, packet, NULL, window->elements, window->elementCount, (Vector2){0, 0}, 0);
+    PopDrawClip(packet);
+    pthread_mutex_unlock(&window->treeLock);
+
+    SortDrawList(packet);
+}
+
+// ----------- Submission -----------
+
+static GpuStage LayerStage(DrawLayer layer) {
+    switch (layer) {
+        case DRAW_LAYER_BACKGROUND: return GPU_STAGE_BACKGROUND;
+        case DRAW_LAYER_CONTENT:    return GPU_STAGE_CONTENT;
+        case DRAW_LAYER_OVERLAY:    return GPU_STAGE_OVERLAY;
+    }
+    return GPU_STAGE_CONTENT;
+}
+
+void SubmitFrame(Window* window, const DrawList* list) {
+    if (list->callCount == 0) return;
+    GpuTimer* timer = window->gpuTimer.ready ? &window->gpuTimer : NULL;
+
+    // Uniforms belong to the shared program, so every window sets its own projection again
+    glUseProgram(uiShader.ID);
+    glUniformMatrix4fv(projectionLocation, 1, GL_FALSE, window->projection);
+
+    glBindVertexArray(window->vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, window->vertexBuffer);
+    // Orphan last frame's storage so the driver never waits on it
+    glBufferData(GL_ARRAY_BUFFER, list->vertexCount * sizeof(DrawVertex), list->sortedVertices, GL_STREAM_DRAW);
+    glActiveTexture(GL_TEXTURE0);
+
+    const DrawCommand* bound = NULL;
+    unsigned int boundTexture = 0;
+    for (size_t i = 0; i < list->callCount; i++) {
+        const DrawCall* call = &list->calls[i];
+        const DrawCommand* command = &list->commands[call->command];
+
+        // Calls are sorted by layer, so every layer is one stage
+        if (timer && (!bound || bound->layer != command->layer)) GpuTimerStage(timer, LayerStage(command->layer));
+
+        // Only touch the state that actually differs from the previous call,
+        // calls without a texture draw with whatever is bound
+        if (!bound || bound->program != command->program) glUseProgram(command->program);
+        if (call->texture && call->texture != boundTexture) {
+            glBindTexture(GL_TEXTURE_2D, call->texture);
+            boundTexture = call->texture;
+        }
+        if (!bound || bound->blend != command->blend) {
+            if (command->blend == DRAW_BLEND_ALPHA) glEnable(GL_BLEND);
+            else glDisable(GL_BLEND);
+        }
+
+        glDrawArrays(GL_TRIANGLES, (GLint)call->firstVertex, (GLsizei)call->vertexCount);
+        bound = command;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glUseProgram(0);
+}
+
+
+// ----------- Update Window -----------
+
+// Marks what frames are built from as changed and asks for a frame showing it
+static void MarkTreeChanged(Window* window) {
+    atomic_fetch_add(&window->treeVersion, 1);
+    atomic_store(&window->dirty, true);
+}
+
+static bool NeedsRedraw(Window* window) {
+    if (window->renderMode == RENDER_CONTINUOUS || atomic_load(&window->dirty) || atomic_load(&imagesDecoded)) return true;
+
+    double now = Now();
+    return now < window->animateUntil || (window->wakeAt > 0 && now >= window->wakeAt);
+}
+
+// Blocks until input arrives or the next scheduled invalidation of any window is due.
+// Events are global, so this never sleeps while another window still has a frame to draw.
+static void WaitForEvents() {
+    if (backend != GUILAY_BACKEND_WINDOWED) return;
+
+    double wakeAt = 0;
+    for (size_t i = 0; i < windowCount; i++) {
+        if (NeedsRedraw(windows[i])) return;
+        if (windows[i]->wakeAt > 0 && (wakeAt == 0 || windows[i]->wakeAt < wakeAt)) wakeAt = windows[i]->wakeAt;
+    }
+
+    if (wakeAt > 0) {
+        double timeout = wakeAt - Now();
+        if (timeout > 0) glfwWaitEventsTimeout(timeout);
+    } else {
+        glfwWaitEvents();
+    }
+}
+
+static void SampleCpuUsage(Window* window) {
+    double now = Now();
+    double elapsed = now - window->sampleStart;
+    if (elapsed < 1.0) return;
+
+    clock_t cpu = clock();
+    window->cpuUsage = (float)((double)(cpu - window->sampleCpuStart) / CLOCKS_PER_SEC / elapsed * 100.0);
+    window->sampleStart = now;
+    window->sampleCpuStart = cpu;
+}
+
+// Creates or drops the window's queries to follow gpuTiming, then starts timing the clear
+static void StartGpuTiming(Window* window) {
+    GpuTimer* timer = &window->gpuTimer;
+    if (!window->gpuTiming) {
+        GpuTimerDestroy(timer);
+        return;
+    }
+
+    if (!timer->ready) GpuTimerInit(timer, GPU_STAGE_COUNT);
+    GpuTimerBeginFrame(timer);
+    GpuTimerStage(timer, GPU_STAGE_CLEAR);
+}
+
+void UpdateWindow(Window* window) {
+    SampleCpuUsage(window);
+
+    if (!NeedsRedraw(window)) {
+        WaitForEvents();
+        if (!NeedsRedraw(window)) return;
+    }
+    atomic_store(&window->dirty, false);
+    if (window->wakeAt > 0 && Now() >= window->wakeAt) window->wakeAt = 0;
+    window->framesRendered++;
+
+    // Frames built from here on can draw the images decoded since the last update
+    MakeWindowCurrent(window);
+    if (UploadDecodedImages()) {
+        for (size_t i = 0; i < windowCount; i++) MarkTreeChanged(windows[i]);
+    }
+
+    // A frame built ahead before the tree changed is fine while more frames follow, but would stay on screen
+    // of a window that is about to sleep
+    bool sleeps = window->renderMode != RENDER_CONTINUOUS && Now() >= window->animateUntil;
+    bool stale = window->requestedVersion != atomic_load(&window->treeVersion);
+    if (ApplyPendingResize(window) || (sleeps && stale)) DiscardFrame(&window->pipeline);
+    DrawList* packet = CollectFrame(&window->pipeline);
+    // Build the next frame while this one is submitted, unless the window is about to sleep
+    if (!sleeps) {
+        window->requestedVersion = atomic_load(&window->treeVersion);
+        RequestFrame(&window->pipeline);
+    }
+    window->stats = packet->stats;
+
+    MakeWindowCurrent(window);
+    if (backend != GUILAY_BACKEND_SOFTWARE) StartGpuTiming(window);
+    ClearFrame(window);
+
+    if (!ProgramsReady()) {
+        GpuTimerEndStage(&window->gpuTimer);
+        // Keeps on demand windows polling until the compile finishes
+        if (!programsFailed) atomic_store(&window->dirty, true);
+        if (backend == GUILAY_BACKEND_WINDOWED) {
+            glfwSwapBuffers(window->openglWindow);
+            glfwPollEvents();
+        }
+        return;
+    }
+
+    if (backend == GUILAY_BACKEND_SOFTWARE) {
+        SoftRasterize(&window->software, packet, softTextures, softTextureCount,
+                      rasterPoolStarted ? &rasterPool : NULL);
+        if (window->present) window->present(window->software.pixels, window->size, window->presentUser);
+        return;
+    }
+
+    // Glyphs and images staged since the last frame
+    FlushUploads(&uploads);
+    SubmitFrame(window, packet);
+    GpuTimerEndStage(&window->gpuTimer);
+
+    if (backend == GUILAY_BACKEND_HEADLESS) {
+        // Nothing is presented, finishing keeps frame timings honest for benchmarks
+        glFinish();
+        return;
+    }
+
+    glfwSwapBuffers(window->openglWindow);
+    glfwPollEvents();
+}
+
+void SetWindowRenderMode(Window* window, RenderMode mode) {
+    window->renderMode = mode;
+    InvalidateWindow(window);
+}
+
+void InvalidateWindow(Window* window) {
+    MarkTreeChanged(window);
+    // Wakes a UpdateWindow blocked in glfwWaitEvents, which makes this safe to call from other threads
+    if (backend == GUILAY_BACKEND_WINDOWED) glfwPostEmptyEvent();
+}
+
+void InvalidateWindowAfter(Window* window, double seconds) {
+    double at = Now() + seconds;
+    if (window->wakeAt == 0 || at < window->wakeAt) window->wakeAt = at;
+}
+
+void AnimateWindow(Window* window, double seconds) {
+    double until = Now() + seconds;
+    if (until > window->animateUntil) window->animateUntil = until;
+}
+
+void ResizeWindow(Window* window, Vector2i size) {
+    if (backend == GUILAY_BACKEND_WINDOWED) return;
+    RequestResize(window, size, window->pendingScale);
+}
+
+Vector2i GetWindowSize(Window* window) {
+    return window->size;
+}
+
+void SetWindowElementStorage(Window* window, ElementStorage storage) {
+    LockWindow(window);
+    window->storage = storage;
+    UnlockWindow(window);
+}
+
+void SetWindowGpuTiming(Window* window, bool enabled) {
+    window->gpuTiming = enabled;
+}
+
+// Finds the child of parent drawn on top at point, offset is what the scrolls around parent add up to
+static Element* GetChildAt(Window* window, const void* parent, Vector2 point, Vector2 offset) {
+    QuadtreeItem* stackResults[64];
+    QuadtreeItem** results = stackResults;
+    Vector2 unscrolled = {point.x + offset.x, point.y + offset.y};
+
+    size_t found = QuadtreeQueryPoint(&window->spatial, unscrolled, results, 64);
+    if (found > 64) {
+        results = malloc(found * sizeof(QuadtreeItem*));
+        if (results) found = QuadtreeQueryPoint(&window->spatial, unscrolled, results, found);
+        else found = 0;
+    }
+
+    // Later siblings are drawn over earlier ones
+    Element* top = NULL;
+    size_t order = 0;
+    for (size_t i = 0; i < found; i++) {
+        if (results[i]->parent == parent && (top == NULL || results[i]->order > order)) {
+            top = results[i]->element;
+            order = results[i]->order;
+        }
+    }
+
+    if (results != stackResults) free(results);
+    return top;
+}
+
+// Descends one section at a time, each scrolls everything inside of it further
+Element* GetElementAt(Window* window, Vector2 point) {
+    Element* top = NULL;
+    Vector2 offset = {0, 0};
+
+    pthread_mutex_lock(&window->treeLock);
+    for (Element* hit = GetChildAt(window, NULL, point, offset); hit;) {
+        top = hit;
+        if (hit->type != SECTION) break;
+        Section* section = hit->data;
+        offset.x += section->scroll.x;
+        offset.y += section->scroll.y;
+        hit = GetChildAt(window, section, point, offset);
+    }
+    pthread_mutex_unlock(&window->treeLock);
+    return top;
+}
+
+AtlasStats GetAtlasStats(AtlasKind atlas) {
+    const AtlasPacker* packer = &atlases[atlas].packer;
+    return (AtlasStats){
+        .size = {packer->width, packer->height},
+        .allocations = packer->stats.allocations,
+        .failures = packer->stats.failures,
+        .freeRects = packer->freeCount,
+        .occupancy = AtlasOccupancy(packer),
+        .allocateMilliseconds = packer->stats.allocateSeconds * 1000.0
+    };
+}
+
+FrameStats GetFrameStats(Window* window) {
+    const DrawListStats* stats = &window->stats;
+    FrameStats frameStats = {
+        .drawCommands = stats->commandCount,
+        .drawCalls = stats->drawCalls,
+        .stateChangesSaved = stats->stateChangesBefore - stats->stateChangesAfter,
+        .framesRendered = window->framesRendered,
+        .culled = stats->culled,
+        .cpuUsage = window->cpuUsage
+    };
+
+    if (window->gpuTimer.ready) {
+        for (int stage = 0; stage < GPU_STAGE_COUNT; stage++) {
+            frameStats.gpuMilliseconds[stage] = (float)window->gpuTimer.milliseconds[stage];
+        }
+    }
+    return frameStats;
+}
+
+void SetWindowPresentCallback(Window* window, WindowPresentCallback present, void* user) {
+    window->present = present;
+    window->presentUser = user;
+}
+
+bool WindowShouldClose(Window* window) {
+    if (backend != GUILAY_BACKEND_WINDOWED) return false;
+    return glfwWindowShouldClose(window->openglWindow);
+}
+
+int ReadWindowPixels(Window* window, uint8_t* pixels) {
+    if (backend == GUILAY_BACKEND_SOFTWARE) {
+        memcpy(pixels, window->software.pixels, (size_t)window->size.x * window->size.y * 4);
+        return 0;
+    }
+
+    // Another window's context may be current, its framebuffer would be read instead
+    MakeWindowCurrent(window);
+    if (backend == GUILAY_BACKEND_HEADLESS) return HeadlessReadPixels(&window->headless, pixels);
+
+    // The back buffer was just swapped away, so read what is on screen
+    size_t rowSize = (size_t)window->size.x * 4;
+    uint8_t* row = malloc(rowSize);
+    if (row == NULL) return 1;
+
+    glReadBuffer(GL_FRONT);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, window->size.x, window->size.y, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glReadBuffer(GL_BACK);
+
+    for (int top = 0, bottom = window->size.y - 1; top < bottom; top++, bottom--) {
+        memcpy(row, pixels + top * rowSize, rowSize);
+        memcpy(pixels + top * rowSize, pixels + bottom * rowSize, rowSize);
+        memcpy(pixels + bottom * rowSize, row, rowSize);
+    }
+
+    free(row);
+    return 0;
+}
+
+void LockWindow(Window* window) {
+    pthread_mutex_lock(&window->treeLock);
+}
+
+// Needs the tree lock, changes holds ReconcileChanges
+static void InvalidateTree(Window* window, int changes) {
+    if (changes & (CHANGED_LAYOUT | CHANGED_TREE)) window->layoutValid = false;
+    if (changes & CHANGED_TREE) window->storeValid = false;
+    if (changes) InvalidateElementPaint(&window->store);
+}
+
+void UnlockWindow(Window* window) {
+    UnlockWindowAfter(window, WINDOW_CHANGED_TREE);
+}
+
+void UnlockWindowAfter(Window* window, WindowChange change) {
+    static const int changes[] = {
+        [WINDOW_CHANGED_PAINT] = CHANGED_PAINT,
+        [WINDOW_CHANGED_LAYOUT] = CHANGED_LAYOUT,
+        [WINDOW_CHANGED_TREE] = CHANGED_TREE
+    };
+    InvalidateTree(window, changes[change]);
+    pthread_mutex_unlock(&window->treeLock);
+    MarkTreeChanged(window);
+}
+
+// Needs the tree lock
+static int AppendElements(Window* window, Element** elements, size_t count) {
+    if (GrowElementsArray(&window->elements, &window->elementCapacity, window->elementCount + count)) return 1;
+    memcpy(window->elements + window->elementCount, elements, count * sizeof(Element*));
+    window->elementCount += count;
+    return 0;
+}
+
+void AddElement(Window* window, Element* element) {
+    LockWindow(window);
+    AppendElements(window, &element, 1);
+    UnlockWindow(window);
+}
+
+void AddElements(Window* window, Element** elements, size_t count) {
+    LockWindow(window);
+    AppendElements(window, elements, count);
+    UnlockWindow(window);
+}
+
+void BeginWindowArena(Window* window) {
+    SetElementArena(&window->arena);
+}
+
+void EndWindowArena() {
+    SetElementArena(NULL);
+}
+
+void ClearWindow(Window* window) {
+    LockWindow(window);
+    // Heap elements may be shown again somewhere else, so their index entries are dropped one by one,
+    // the tree itself goes in one go
+    ClearSpatialIndex(window->elements, window->elementCount);
+    QuadtreeDestroy(&window->spatial);
+    QuadtreeInit(&window->spatial, (Rect){{0, 0}, window->layoutSize});
+    window->elementCount = 0;
+    ArenaReset(&window->arena);
+    ResetElementPool(&window->pool);
+    UnlockWindow(window);
+}
+
+// ----------- Pooled elements -----------
+
+// Takes a slot for an element under parent and links it in, the caller fills in the payload.
+// Needs the tree lock, returns NULL when parent is not a live section or the pool is out of memory.
+static ElementSlot* SpawnSlot(Window* window, ElementHandle parent, ElementType type) {
+    Section* section = NULL;
+    uint32_t parentSlot = ELEMENT_SLOT_NONE;
+
+    if (parent.generation != 0) {
+        ElementSlot* owner = ResolveElementHandle(&window->pool, parent);
+        if (owner == NULL || owner->element.type != SECTION) return NULL;
+        section = &owner->data.section;
+        parentSlot = parent.index;
+    }
+
+    // The pool never moves slots, so section stays valid while it grows
+    ElementSlot* slot = AcquireElementSlot(&window->pool, type, parentSlot);
+    if (slot == NULL) return NULL;
+
+    Element* element = &slot->element;
+    size_t count = section ? section->childrenCount : window->elementCount;
+    if (section) AddSectionChild(section, element);
+    else AppendElements(window, &element, 1);
+
+    if ((section ? section->childrenCount : window->elementCount) == count) {
+        ReleaseElementSlot(&window->pool, element->slot);
+        return NULL;
+    }
+    return slot;
+}
+
+static ElementHandle FinishSpawn(Window* window, ElementSlot* slot) {
+    ElementHandle handle = slot ? GetSlotHandle(slot) : NULL_ELEMENT;
+    UnlockWindow(window);
+    return handle;
+}
+
+ElementHandle SpawnText(Window* window, ElementHandle parent, Vector2 size, char* text, float scale, Color color) {
+    LockWindow(window);
+    ElementSlot* slot = SpawnSlot(window, parent, TEXT);
+    if (slot) {
+        StringView view = ViewString(text);
+        slot->data.text = (Text){.size = size, .scale = scale, .text = view.data, .length = view.length, .color = color};
+    }
+    return FinishSpawn(window, slot);
+}
+
+ElementHandle SpawnSection(Window* window, ElementHandle parent, Vector2 size, Color color) {
+    LockWindow(window);
+    ElementSlot* slot = SpawnSlot(window, parent, SECTION);
+    if (slot) slot->data.section = (Section){.size = size, .color = color};
+    return FinishSpawn(window, slot);
+}
+
+ElementHandle SpawnButton(Window* window, ElementHandle parent, Vector2 size, Color color, Text* text,
+                          void (*onClick)(void)) {
+    LockWindow(window);
+    ElementSlot* slot = SpawnSlot(window, parent, BUTTON);
+    if (slot) slot->data.button = (Button){.size = size, .color = color, .text = text, .onClick = onClick};
+    return FinishSpawn(window, slot);
+}
+
+ElementHandle SpawnImage(Window* window, ElementHandle parent, Vector2 size, char* path) {
+    LockWindow(window);
+    ElementSlot* slot = SpawnSlot(window, parent, IMAGE);
+    if (slot) {
+        slot->data.image = (Image){.size = size, .path = path, .tint = {255, 255, 255, 255}};
+        slot->data.image.resource = RequestImage(path);
+    }
+    return FinishSpawn(window, slot);
+}
+
+void* GetElementData(Window* window, ElementHandle handle) {
+    pthread_mutex_lock(&window->treeLock);
+    ElementSlot* slot = ResolveElementHandle(&window->pool, handle);
+    pthread_mutex_unlock(&window->treeLock);
+    return slot ? &slot->data : NULL;
+}
+
+bool IsElementAlive(Window* window, ElementHandle handle) {
+    return GetElementData(window, handle) != NULL;
+}
+
+// Drops element from a child list, keeping the order of the rest
+static size_t UnlinkElement(Element** elements, size_t count, Element* element) {
+    for (size_t i = 0; i < count; i++) {
+        if (elements[i] != element) continue;
+        memmove(elements + i, elements + i + 1, (count - i - 1) * sizeof(Element*));
+        return count - 1;
+    }
+    return count;
+}
+
+// Takes element and everything below it out of the spatial index and gives pooled ones back to the pool
+static void ReleaseSubtree(Window* window, Element* element) {
+    // Entries of elements once taken out by hand may have been pruned and handed to another element since
+    if (element->spatial && element->spatial->element == element) QuadtreeRemove(&window->spatial, element->spatial);
+    element->spatial = NULL;
+
+    if (element->type == SECTION) {
+        Section* section = element->data;
+        for (size_t i = 0; i < section->childrenCount; i++) ReleaseSubtree(window, section->children[i]);
+    }
+    if (element->slot != ELEMENT_SLOT_NONE) ReleaseElementSlot(&window->pool, element->slot);
+}
+
+void RemoveElement(Window* window, ElementHandle handle) {
+    LockWindow(window);
+    ElementSlot* slot = ResolveElementHandle(&window->pool, handle);
+    if (slot == NULL) {
+        pthread_mutex_unlock(&window->treeLock);
+        return;
+    }
+
+    if (slot->parent == ELEMENT_SLOT_NONE) {
+        window->elementCount = UnlinkElement(window->elements, window->elementCount, &slot->element);
+    } else {
+        Section* parent = &GetElementSlot(&window->pool, slot->parent)->data.section;
+        parent->childrenCount = UnlinkElement(parent->children, parent->childrenCount, &slot->element);
+    }
+    ReleaseSubtree(window, &slot->element);
+    UnlockWindow(window);
+}
+
+void AddText(Window* window, Text* text) {
+    AddElement(window, CreateTextElement(text));
+}
+
+// ----------- Layout files -----------
+
+struct LayoutFile {
+    LayoutMapping mapping;
+};
+
+// Everything an element of a layout file needs, one per record
+typedef struct LayoutPayload {
+    union {
+        Text text;
+        Section section;
+        Button button;
+        Image image;
+    } data;
+    Text label; // Buttons
+} LayoutPayload;
+
+LayoutFile* OpenLayoutFile(const char* path) {
+    LayoutFile* layout = malloc(sizeof(LayoutFile));
+    if (layout == NULL) return NULL;
+    if (MapLayout(&layout->mapping, path)) {
+        free(layout);
+        return NULL;
+    }
+    return layout;
+}
+
+void CloseLayoutFile(LayoutFile* layout) {
+    if (layout == NULL) return;
+    UnmapLayout(&layout->mapping);
+    free(layout);
+}
+
+static Color LayoutColor(const uint8_t* color) {
+    return (Color){.red = color[0], .green = color[1], .blue = color[2], .alpha = color[3]};
+}
+
+// Points the list at the children of [first, end), returns where the next list starts
+static size_t LinkLayoutChildren(const LayoutRecord* records, Element* elements, Element** lists, size_t list,
+                                 uint32_t first, uint32_t end, size_t* count) {
+    *count = 0;
+    for (uint32_t i = first; i < end; i = records[i].end) lists[list + (*count)++] = &elements[i];
+    return list + *count;
+}
+
+int AddLayout(Window* window, const LayoutFile* layout) {
+    const LayoutHeader* header = GetLayoutHeader(&layout->mapping);
+    const LayoutRecord* records = GetLayoutRecords(&layout->mapping);
+    const char* strings = GetLayoutStrings(&layout->mapping);
+    size_t count = header->elementCount;
+    if (count == 0) return 0;
+
+    LockWindow(window);
+    // Three allocations for the whole screen, every element is in exactly one child list
+    Arena* arena = &window->arena;
+    Element* elements = ArenaAlloc(arena, count * sizeof(Element));
+    LayoutPayload* payloads = ArenaAlloc(arena, count * sizeof(LayoutPayload));
+    Element** lists = ArenaAlloc(arena, count * sizeof(Element*));
+    if (elements == NULL || payloads == NULL || lists == NULL) {
+        pthread_mutex_unlock(&window->treeLock);
+        fprintf(stderr, "Error: Layout allocation failed.\n");
+        return 1;
+    }
+
+    size_t rootCount;
+    size_t list = LinkLayoutChildren(records, elements, lists, 0, 0, (uint32_t)count, &rootCount);
+
+    for (size_t i = 0; i < count; i++) {
+        const LayoutRecord* record = &records[i];
+        LayoutPayload* payload = &payloads[i];
+        Vector2 size = {record->size[0], record->size[1]};
+        Color color = LayoutColor(record->color);
+        // Strings are shown straight from the file
+        const char* text = strings + record->text;
+
+        switch ((ElementType)record->type) {
+            case TEXT:
+                payload->data.text = (Text){.size = size, .scale = record->scale, .color = color,
+                                            .text = text, .length = record->length};
+                break;
+            case SECTION: {
+                size_t childCount;
+                Element** children = lists + list;
+                list = LinkLayoutChildren(records, elements, lists, list, (uint32_t)i + 1, record->end, &childCount);
+                payload->data.section = (Section){.size = size, .color = color,
+                                                  .scroll = {record->scroll[0], record->scroll[1]},
+                                                  .children = children, .childrenCount = childCount,
+                                                  .childrenCapacity = childCount, .arena = arena};
+                break;
+            }
+            case BUTTON:
+                payload->label = (Text){.size = size, .scale = record->scale, .color = LayoutColor(record->labelColor),
+                                        .text = text, .length = record->length};
+                payload->data.button = (Button){.size = size, .color = color,
+                                                .text = record->length ? &payload->label : NULL};
+                break;
+            case IMAGE:
+                // Decoding starts once the image is first drawn
+                payload->data.image = (Image){.size = size, .path = (char*)text, .tint = color};
+                break;
+        }
+        elements[i] = (Element){.type = (ElementType)record->type, .data = &payload->data, .slot = ELEMENT_SLOT_NONE};
+    }
+
+    int failed = AppendElements(window, lists, rootCount);
+    UnlockWindow(window);
+    return failed;
+}
+
+// ----------- Descriptions -----------
+
+void BeginDescription(Window* window) {
+    ResetDescription(&window->description);
+}
+
+void DescribeText(Window* window, uint64_t key, Vector2 size, StringView text, float scale, Color color) {
+    DescribedElement* element = DescribeElement(&window->description, TEXT, key, text);
+    if (element == NULL) return;
+    element->size = size;
+    element->scale = scale;
+    element->color = color;
+}
+
+void DescribeButton(Window* window, uint64_t key, Vector2 size, Color color, StringView label, float labelScale,
+                    Color labelColor, void (*onClick)(void)) {
+    DescribedElement* element = DescribeElement(&window->description, BUTTON, key, label);
+    if (element == NULL) return;
+    element->size = size;
+    element->color = color;
+    element->scale = labelScale;
+    element->labelColor = labelColor;
+    element->onClick = onClick;
+}
+
+void DescribeImage(Window* window, uint64_t key, Vector2 size, char* path, Color tint) {
+    DescribedElement* element = DescribeElement(&window->description, IMAGE, key, ViewString(path));
+    if (element == NULL) return;
+    element->size = size;
+    element->color = tint;
+}
+
+void BeginDescribedSection(Window* window, uint64_t key, Vector2 size, Color color, Vector2 scroll) {
+    DescribedElement* element = DescribeElement(&window->description, SECTION, key, (StringView){"", 0});
+    if (element == NULL) return;
+    element->size = size;
+    element->color = color;
+    element->scroll = scroll;
+    OpenDescribedSection(&window->description);
+}
+
+void EndDescribedSection(Window* window) {
+    CloseDescribedSection(&window->description);
+}
+
+static bool SameColor(Color a, Color b) {
+    return a.red == b.red && a.green == b.green && a.blue == b.blue && a.alpha == b.alpha;
+}
+
+static bool SameVector(Vector2 a, Vector2 b) {
+    return a.x == b.x && a.y == b.y;
+}
+
+// Copies text into the slot unless it already holds it, current is the length of what it holds.
+// Returns 1 when the copy could not be allocated, the slot keeps its old characters then.
+static int SetSlotCharacters(ElementSlot* slot, size_t current, StringView text, bool* changed) {
+    *changed = false;
+    if (slot->characters && current == text.length && memcmp(slot->characters, text.data, text.length) == 0) return 0;
+
+    char* characters = realloc(slot->characters, text.length + 1);
+    if (characters == NULL) return 1;
+    memcpy(characters, text.data, text.length);
+    characters[text.length] = '\0';
+    slot->characters = characters;
+    *changed = true;
+    return 0;
+}
+
+// Makes a slot match its description and adds the ReconcileChanges it took to changes.
+// Returns 1 when the characters could not be copied, the slot is left exactly as it was then.
+static int ApplyDescription(const Description* description, const DescribedElement* described, ElementSlot* slot,
+                            int* changes) {
+    StringView text = GetDescribedText(description, described);
+    bool textChanged;
+
+    switch (described->type) {
+        case TEXT: {
+            Text* t = &slot->data.text;
+            if (SetSlotCharacters(slot, t->length, text, &textChanged)) return 1;
+            if (textChanged) *changes |= CHANGED_PAINT;
+            if (!SameVector(t->size, described->size)) *changes |= CHANGED_LAYOUT;
+            if (!SameColor(t->color, described->color) || t->scale != described->scale) *changes |= CHANGED_PAINT;
+            *t = (Text){.size = described->size, .scale = described->scale, .color = described->color,
+                        .text = slot->characters, .length = text.length};
+            break;
+        }
+        case SECTION: {
+            Section* section = &slot->data.section;
+            if (!SameVector(section->size, described->size)) *changes |= CHANGED_LAYOUT;
+            if (!SameColor(section->color, described->color) || !SameVector(section->scroll, described->scroll)) {
+                *changes |= CHANGED_PAINT;
+            }
+            section->size = described->size;
+            section->scroll = described->scroll;
+            section->color = described->color;
+            break;
+        }
+        case BUTTON: {
+            Button* button = &slot->data.button;
+            Text* label = &slot->label;
+            if (SetSlotCharacters(slot, label->length, text, &textChanged)) return 1;
+            if (textChanged) *changes |= CHANGED_PAINT;
+            if (!SameVector(button->size, described->size)) *changes |= CHANGED_LAYOUT;
+            if (!SameColor(button->color, described->color) || !SameColor(label->color, described->labelColor) ||
+                label->scale != described->scale) *changes |= CHANGED_PAINT;
+            *label = (Text){.size = described->size, .scale = described->scale, .color = described->labelColor,
+                            .text = slot->characters, .length = text.length};
+            *button = (Button){.size = described->size, .color = described->color,
+                               .text = text.length ? label : NULL, .onClick = described->onClick};
+            break;
+        }
+        case IMAGE: {
+            Image* image = &slot->data.image;
+            if (SetSlotCharacters(slot, image->path ? strlen(image->path) : 0, text, &textChanged)) return 1;
+            if (!SameVector(image->size, described->size)) *changes |= CHANGED_LAYOUT;
+            if (!SameColor(image->tint, described->color)) *changes |= CHANGED_PAINT;
+            if (textChanged) {
+                image->path = slot->characters;
+                image->resource = RequestImage(image->path);
+                *changes |= CHANGED_PAINT;
+            }
+            image->size = described->size;
+            image->tint = described->color;
+            break;
+        }
+    }
+    return 0;
+}
+
+static int GrowArray(void** array, size_t* capacity, size_t needed, size_t itemSize) {
+    if (needed <= *capacity) return 0;
+
+    size_t grown = *capacity ? *capacity : 64;
+    while (grown < needed) grown *= 2;
+    void* items = realloc(*array, grown * itemSize);
+    if (items == NULL) return 1;
+    *array = items;
+    *capacity = grown;
+    return 0;
+}
+
+static size_t KeyBucket(uint64_t key, size_t mask) {
+    return (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+}
+
+// Finds the old described element with key and type that was not taken yet and takes it.
+// The one at the same position is tried first, it is the one almost every time.
+static Element* TakePrevious(Window* window, size_t count, size_t position, uint64_t key, ElementType type) {
+    Reconciler* r = &window->reconciler;
+    ElementPool* pool = &window->pool;
+
+    if (position < count && r->previous[position] && r->previous[position]->type == type &&
+        GetElementSlot(pool, r->previous[position]->slot)->key == key) {
+        Element* element = r->previous[position];
+        r->previous[position] = NULL;
+        return element;
+    }
+
+    size_t mask = r->keyMask;
+    for (size_t bucket = KeyBucket(key, mask); r->keys[bucket]; bucket = (bucket + 1) & mask) {
+        Element** candidate = &r->previous[r->keys[bucket] - 1];
+        if (*candidate && (*candidate)->type == type && GetElementSlot(pool, (*candidate)->slot)->key == key) {
+            Element* element = *candidate;
+            *candidate = NULL;
+            return element;
+        }
+    }
+    return NULL;
+}
+
+// Matches the described elements in [first, end) against the described ones in the child list by key, then writes
+// the new list. Elements added some other way stay in front of them. Sections are reconciled after their list.
+static void ReconcileChildren(Window* window, uint32_t parent, Element*** children, size_t* count, size_t* capacity,
+                              uint32_t first, uint32_t end) {
+    Reconciler* r = &window->reconciler;
+    const Description* description = &window->description;
+    ElementPool* pool = &window->pool;
+    size_t previousCount = *count;
+
+    size_t described = 0;
+    for (uint32_t i = first; i < end; i = description->elements[i].end) described++;
+
+    size_t keyCapacity = 16;
+    while (keyCapacity < previousCount * 2) keyCapacity *= 2;
+    // The child list is grown up front as well, so nothing can fail once elements start being released
+    if (GrowArray((void**)&r->previous, &r->previousCapacity, previousCount, sizeof(Element*)) ||
+        GrowArray((void**)&r->next, &r->nextCapacity, previousCount + described, sizeof(Element*)) ||
+        GrowArray((void**)&r->keys, &r->keyCapacity, keyCapacity, sizeof(uint32_t)) ||
+        GrowElementsArray(children, capacity, previousCount + described)) {
+        fprintf(stderr, "Error: Reconciliation allocation failed.\n");
+        r->stats.failed += described;
+        return;
+    }
+
+    // Described elements by key, the rest go to the front of the new list untouched
+    size_t mask = keyCapacity - 1;
+    r->keyMask = mask;
+    memset(r->keys, 0, keyCapacity * sizeof(uint32_t));
+    size_t nextCount = 0;
+    for (size_t i = 0; i < previousCount; i++) {
+        Element* element = (*children)[i];
+        bool owned = element->slot != ELEMENT_SLOT_NONE && GetElementSlot(pool, element->slot)->described;
+        r->previous[i] = owned ? element : NULL;
+        if (!owned) {
+            r->next[nextCount++] = element;
+            continue;
+        }
+
+        size_t bucket = KeyBucket(GetElementSlot(pool, element->slot)->key, mask);
+        while (r->keys[bucket]) bucket = (bucket + 1) & mask;
+        r->keys[bucket] = (uint32_t)(i + 1);
+    }
+    size_t kept = nextCount;
+
+    for (uint32_t i = first; i < end; i = description->elements[i].end) {
+        const DescribedElement* wanted = &description->elements[i];
+        Element* element = TakePrevious(window, previousCount, nextCount, wanted->key, wanted->type);
+        ElementSlot* slot;
+
+        if (element) {
+            slot = GetElementSlot(pool, element->slot);
+        } else {
+            slot = AcquireElementSlot(pool, wanted->type, parent);
+            if (slot == NULL) {
+                r->stats.failed++;
+                continue;
+            }
+            slot->described = true;
+            slot->key = wanted->key;
+        }
+
+        // Out of memory a new element is not created at all and an old one stays as it was
+        int changes = 0;
+        if (ApplyDescription(description, wanted, slot, &changes)) {
+            r->stats.failed++;
+            if (element == NULL) {
+                ReleaseElementSlot(pool, slot->element.slot);
+                continue;
+            }
+        } else if (element == NULL) {
+            r->stats.inserted++;
+            changes |= CHANGED_TREE;
+        } else if (changes) {
+            r->stats.updated++;
+        } else {
+            r->stats.unchanged++;
+        }
+        r->changes |= changes;
+        r->next[nextCount++] = &slot->element;
+    }
+
+    for (size_t i = 0; i < previousCount; i++) {
+        if (r->previous[i] == NULL) continue;
+        ReleaseSubtree(window, r->previous[i]);
+        r->stats.removed++;
+        r->changes |= CHANGED_TREE;
+    }
+
+    if (nextCount != previousCount || (nextCount && memcmp(*children, r->next, nextCount * sizeof(Element*)) != 0)) {
+        memcpy(*children, r->next, nextCount * sizeof(Element*));
+        *count = nextCount;
+        r->stats.reordered++;
+        r->changes |= CHANGED_TREE;
+    }
+
+    // The scratch arrays belong to the sections from here on, so the list is walked again next to the description.
+    // Elements that got no slot are missing from the list, the keys tell them apart.
+    size_t position = kept;
+    for (uint32_t i = first; i < end && position < *count; i = description->elements[i].end) {
+        Element* element = (*children)[position];
+        ElementSlot* slot = GetElementSlot(pool, element->slot);
+        if (slot->key != description->elements[i].key || element->type != description->elements[i].type) continue;
+        position++;
+
+        if (element->type != SECTION) continue;
+        Section* section = &slot->data.section;
+        ReconcileChildren(window, element->slot, &section->children, &section->childrenCount,
+                          &section->childrenCapacity, i + 1, description->elements[i].end);
+    }
+}
+
+ReconcileStats SubmitDescription(Window* window) {
+    Description* description = &window->description;
+    Reconciler* r = &window->reconciler;
+
+    while (description->depth) CloseDescribedSection(description);
+    // A description that ran out of memory would remove whatever it missed, so the window keeps the last one
+    if (description->failed) return (ReconcileStats){.failed = description->count};
+
+    pthread_mutex_lock(&window->treeLock);
+    memset(&r->stats, 0, sizeof(ReconcileStats));
+    r->changes = 0;
+    ReconcileChildren(window, ELEMENT_SLOT_NONE, &window->elements, &window->elementCount, &window->elementCapacity,
+                      0, (uint32_t)description->count);
+
+    // Only what changed is redone, an identical description does not even cause a frame
+    InvalidateTree(window, r->changes);
+    ReconcileStats stats = r->stats;
+    pthread_mutex_unlock(&window->treeLock);
+
+    if (r->changes) MarkTreeChanged(window);
+    return stats;
+}
+
+// ----------- Strings -----------
+
+StringId InternString(StringView string) {
+    pthread_mutex_lock(&stringLock);
+    StringId id = StringTableIntern(&strings, string);
+    pthread_mutex_unlock(&stringLock);
+    return id;
+}
+
+StringView GetInternedString(StringId id) {
+    pthread_mutex_lock(&stringLock);
+    InternedString* entry = StringTableGet(&strings, id);
+    StringView string = entry ? entry->string : (StringView){"", 0};
+    pthread_mutex_unlock(&stringLock);
+    return string;
+}
+
+Text* CreateInternedText(Vector2 size, StringId id, float scale, Color color) {
+    Text* text = CreateTextView(size, (StringView){"", 0}, scale, color);
+    SetTextString(text, id);
+    return text;
+}
+
+void SetTextString(Text* text, StringId id) {
+    pthread_mutex_lock(&stringLock);
+    InternedString* entry = StringTableGet(&strings, id);
+    pthread_mutex_unlock(&stringLock);
+
+    // Entries never move and never change, so the view stays good without the lock
+    SetTextView(text, entry ? entry->string : (StringView){"", 0});
+    text->id = entry ? id : 0;
+}
+
+// Advance of every character at scale 1, needs the font
+static float MeasureCharacters(StringView string) {
+    unsigned int advance = 0;
+    for (size_t i = 0; i < string.length; i++) {
+        unsigned char c = (unsigned char)string.data[i];
+        if (c < CHARACTER_LOAD_COUNT) advance += characters[c].Advance >> 6;
+    }
+    return (float)advance;
+}
+
+float MeasureText(Text* text) {
+    if (text->id == 0) return MeasureCharacters((StringView){text->text, text->length}) * text->scale;
+
+    pthread_mutex_lock(&stringLock);
+    InternedString* entry = StringTableGet(&strings, text->id);
+    float width = entry->width;
+    if (width < 0) {
+        width = MeasureCharacters(entry->string);
+        // Nothing is cached before the font is loaded
+        if (sharedAssetsLoaded) entry->width = width;
+    }
+    pthread_mutex_unlock(&stringLock);
+    return width * text->scale;
+}
+
+void AddImage(Window* window, Image* image) {
+    image->resource = RequestImage(image->path);
+    AddElement(window, CreateImageElement(image));
 }
\ No newline at end of file
@@ -4,39 +4,254 @@
 #include "common/types.h"
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
-#define MAX_ELEMENTS 255
-
 // A window, chaging internal values without using the proper functions is not reccomended
 typedef struct Window Window;
 
 typedef struct Character Character;
+typedef struct Element Element;
+
+// Elements are drawn with the alpha of their colors, fills, text and image tints all blend by it.
+// Give all four components: a literal like (Color){r, g, b} leaves alpha at 0, which draws nothing.
+// FillWindow is the exception, windows are always cleared opaque.
+
+// Render stages timed on the GPU, see SetWindowGpuTiming
+typedef enum {
+    GPU_STAGE_CLEAR,
+    GPU_STAGE_BACKGROUND, // Section and button fills
+    GPU_STAGE_CONTENT,    // Text and images
+    GPU_STAGE_OVERLAY,
+    GPU_STAGE_COUNT
+} GpuStage;
+
+// Statistics about the last frame drawn to a window
+typedef struct FrameStats {
+    size_t drawCommands;      // Commands recorded while walking the element tree
+    size_t drawCalls;         // Draw calls left after sorting and merging
+    size_t stateChangesSaved; // Program, texture and blend switches removed by sorting
+    size_t framesRendered;    // Frames actually drawn since the window was created
+    size_t culled;            // Elements and glyphs skipped for being outside of the window or their sections
+    float cpuUsage;           // Percent of one core the process used, sampled at most once a second
+    // Milliseconds of GPU time per GpuStage, from a frame a few frames back so reading them never stalls.
+    // All 0 unless SetWindowGpuTiming turned timing on.
+    float gpuMilliseconds[GPU_STAGE_COUNT];
+} FrameStats;
+
+// Textures shared by every window that pack many small pictures, so drawing from one never switches textures
+typedef enum {
+    ATLAS_GLYPHS, // Every glyph of the font
+    ATLAS_IMAGES, // Images up to 128x128
+    ATLAS_COUNT
+} AtlasKind;
+
+// How well an atlas is packed, for tuning atlas sizes and the packer
+typedef struct AtlasStats {
+    Vector2i size;
+    size_t allocations;          // Rectangles currently handed out
+    size_t failures;             // Requests that did not fit, images fall back to their own textures then
+    size_t freeRects;            // Free rectangles the packer tracks, grows with fragmentation
+    float occupancy;             // Share of the atlas in use from 0 to 1, padding included
+    double allocateMilliseconds; // Time spent finding space so far
+} AtlasStats;
+
+// When UpdateWindow draws a frame
+typedef enum {
+    RENDER_CONTINUOUS, // Every call, the default
+    RENDER_ON_DEMAND   // Only after input, an invalidation or while animating, otherwise UpdateWindow blocks for events
+} RenderMode;
+
+
+// What changed between LockWindow and UnlockWindowAfter, the less the cheaper the next frame
+typedef enum {
+    WINDOW_CHANGED_PAINT,  // Colors, strings, images or section scrolls, the layout is kept
+    WINDOW_CHANGED_LAYOUT, // Sizes as well, every element is still where it was in the tree
+    WINDOW_CHANGED_TREE    // Elements were added, removed or moved, what UnlockWindow assumes
+} WindowChange;
+
+// How a window keeps its elements for layout and drawing
+typedef enum {
+    ELEMENT_STORAGE_TREE, // Walks the Element pointers every pass, the default
+    // Copies the tree into parallel arrays in pre-order, layout and drawing then stream through them linearly.
+    // Only tree changes copy it again, colors, texts and sizes are patched in place. The layout pass itself is
+    // about twice as fast, whole frames cost about the same as the tree and tree changes pay for the copy.
+    ELEMENT_STORAGE_FLAT
+} ElementStorage;
 
+// Where windows render to
+typedef enum {
+    GUILAY_BACKEND_WINDOWED, // A visible GLFW window
+    GUILAY_BACKEND_HEADLESS, // An offscreen EGL context, needs a build with make HEADLESS=1
+    GUILAY_BACKEND_SOFTWARE  // CPU rasterization into memory, never touches OpenGL
+} GuilayBackend;
+
+// Receives every finished frame of the software backend as size.x * size.y RGBA values, top row first
+typedef void (*WindowPresentCallback)(const uint8_t* pixels, Vector2i size, void* user);
 
 // initializes guilay
 int GuilayInit();
-// Loads the assets
+// initializes guilay with a specific backend, GuilayInit uses GUILAY_BACKEND_WINDOWED
+int GuilayInitBackend(GuilayBackend backend);
+// Loads the assets, shared ones are only loaded for the first window
 int LoadAssets(Window* window);
 // Cleanly exits guilay
 void GuilayExit();
 
 // Creates a window
 // Items added to the window are layed out in order of how they are added by defualt.
+// Every window shares the fonts and shaders of the first one, call LoadAssets for each window.
 Window* CreateWindow(Vector2i size, char* name);
+// Closes a window and frees it, the elements added to it are left to the caller
+void DestroyWindow(Window* window);
 // Fills a window with a color
 void FillWindow(Window* window, Color fillColor);
 // Updates the window
 void UpdateWindow(Window* window);
+// Sets when UpdateWindow draws a frame
+void SetWindowRenderMode(Window* window, RenderMode mode);
+// Makes the next UpdateWindow draw a frame, can be called from any thread
+void InvalidateWindow(Window* window);
+// Schedules an invalidation, like a clock that has to tick once a second
+void InvalidateWindowAfter(Window* window, double seconds);
+// Keeps drawing every frame for the given time, for animations
+void AnimateWindow(Window* window, double seconds);
 // If the windows should close
 bool WindowShouldClose(Window* window);
+// Frames are built on a worker thread, wrap any direct changes to elements already in the window with these.
+// UnlockWindow lays the window out again, UnlockWindowAfter only redoes what change needs.
+void LockWindow(Window* window);
+void UnlockWindow(Window* window);
+void UnlockWindowAfter(Window* window, WindowChange change);
+// Resizes an offscreen window on the next UpdateWindow, like a framebuffer size event does for a real one.
+// Windowed windows follow their OS window and ignore this.
+void ResizeWindow(Window* window, Vector2i size);
+// Gets the window size in pixels, which ReadWindowPixels and the present callback use
+Vector2i GetWindowSize(Window* window);
+// Picks how the window stores its elements, see ElementStorage
+void SetWindowElementStorage(Window* window, ElementStorage storage);
+// Times every render stage with GPU queries, costs a few queries per frame so it is off by default
+void SetWindowGpuTiming(Window* window, bool enabled);
+// Gets the element drawn on top at point, in layout units from the top left of the window, or NULL.
+// Uses the bounds of the last layout and the current scrolls, a quadtree keeps this logarithmic in the element count.
+Element* GetElementAt(Window* window, Vector2 point);
+// Gets how full an atlas is and what packing it cost so far
+AtlasStats GetAtlasStats(AtlasKind atlas);
+// Gets the statistics of the last frame drawn to the window
+FrameStats GetFrameStats(Window* window);
+// Copies the last frame into pixels as size.x * size.y RGBA values, top row first
+int ReadWindowPixels(Window* window, uint8_t* pixels);
+// Sets where the software backend presents its frames, like a framebuffer device or an image upload
+void SetWindowPresentCallback(Window* window, WindowPresentCallback present, void* user);
+
+// Makes the Create functions of the calling thread allocate from the window until EndWindowArena.
+// Elements, their payloads, child arrays and copies of their strings are carved out of a few big blocks,
+// so a screen of thousands of elements costs a handful of allocations.
+void BeginWindowArena(Window* window);
+void EndWindowArena();
+// Removes every element from the window and frees everything its arena holds at once.
+// Elements created outside of the arena are left to the caller as always.
+void ClearWindow(Window* window);
 
 typedef struct Text Text;
 
 // Creates a button that gets rendered
 Text* CreateText(Vector2 size, char* text, float scale, Color color);
+// Creates a text showing the characters of view in place, nothing is copied or measured with strlen.
+// The memory has to stay unchanged and alive until the text is freed or shows something else.
+Text* CreateTextView(Vector2 size, StringView view, float scale, Color color);
+// Points a text at new characters without copying them, same contract as CreateTextView.
+// Call between LockWindow and UnlockWindow when the text is in a window.
+void SetTextView(Text* text, StringView view);
+// Views a 0 terminated string
+StringView ViewString(const char* string);
+
+// Stores a string once for the whole process and returns its id, the same characters always give the same id.
+// Labels repeated thousands of times then share one copy, and caches can key on the id instead of the text.
+StringId InternString(StringView string);
+// Gets the characters of an interned string, they stay valid until GuilayExit. Unknown ids give an empty string.
+StringView GetInternedString(StringId id);
+// Creates a text showing an interned string
+Text* CreateInternedText(Vector2 size, StringId id, float scale, Color color);
+// Makes a text show an interned string, call between LockWindow and UnlockWindow when the text is in a window
+void SetTextString(Text* text, StringId id);
+// Gets how wide a text is drawn at its scale. Interned strings are measured once, needs LoadAssets.
+float MeasureText(Text* text);
 // Adds a button to the window
 void AddText(Window* window, Text* button);
+// Adds an element to the end of the window, the array of the window doubles as it fills up
+void AddElement(Window* window, Element* element);
+// Adds count elements in one go, with one lock and at most one reallocation
+void AddElements(Window* window, Element** elements, size_t count);
+
+typedef struct Image Image;
+
+// Creates an image of a TGA or binary PPM file, its pixels are multiplied by tint which starts out white
+Image* CreateImage(Vector2 size, char* path);
+// Adds an image to the window and starts decoding its file on a background thread.
+// Small images share one atlas texture, so a row of icons is a single draw.
+void AddImage(Window* window, Image* image);
+
+// Spawn functions create elements in pooled slots owned by the window and add them to parent, a section
+// handle, or to the window itself for NULL_ELEMENT. Rows and tooltips that come and go reuse freed slots
+// instead of touching the heap. Strings are borrowed like with the Create functions.
+// They return NULL_ELEMENT when parent is not a live section or memory ran out.
+ElementHandle SpawnText(Window* window, ElementHandle parent, Vector2 size, char* text, float scale, Color color);
+ElementHandle SpawnSection(Window* window, ElementHandle parent, Vector2 size, Color color);
+ElementHandle SpawnButton(Window* window, ElementHandle parent, Vector2 size, Color color, Text* text,
+                          void (*onClick)(void));
+ElementHandle SpawnImage(Window* window, ElementHandle parent, Vector2 size, char* path);
+// Gets the Text, Section, Button or Image of a spawned element, NULL once it was removed.
+// Change it between LockWindow and UnlockWindow like any element in a window.
+void* GetElementData(Window* window, ElementHandle handle);
+bool IsElementAlive(Window* window, ElementHandle handle);
+// Removes a spawned element and everything inside of it, stale handles are ignored.
+// Spawned elements go back to the pool, anything added to a spawned section some other way is left to the caller.
+// ClearWindow removes every spawned element as well.
+void RemoveElement(Window* window, ElementHandle handle);
+
+// What SubmitDescription did to the window
+typedef struct ReconcileStats {
+    size_t inserted;  // Elements created for new keys
+    size_t removed;   // Elements whose key was not described again, along with everything inside of them
+    size_t updated;   // Elements that kept their key but changed
+    size_t unchanged;
+    size_t reordered; // Child lists that were written again
+    size_t failed;    // Described elements memory ran out for, they were not created or kept their old state
+} ReconcileStats;
+
+// Declarative building: describe the whole UI from application state between BeginDescription and
+// SubmitDescription, every tick if need be. Submitting matches the description against the elements the
+// last one created by key among siblings, and only applies the difference: new keys are created, missing
+// ones removed and the rest updated in place. An identical description changes nothing and draws no frame,
+// color and string changes keep the layout. Described elements come after elements added any other way.
+// Strings are copied, so they can come from a temporary buffer. Only one thread describes a window at a time.
+void BeginDescription(Window* window);
+void DescribeText(Window* window, uint64_t key, Vector2 size, StringView text, float scale, Color color);
+// An empty label draws no text
+void DescribeButton(Window* window, uint64_t key, Vector2 size, Color color, StringView label, float labelScale,
+                    Color labelColor, void (*onClick)(void));
+void DescribeImage(Window* window, uint64_t key, Vector2 size, char* path, Color tint);
+// Everything described until EndDescribedSection goes inside of the section
+void BeginDescribedSection(Window* window, uint64_t key, Vector2 size, Color color, Vector2 scroll);
+void EndDescribedSection(Window* window);
+// Closes sections left open and reconciles, a description that ran out of memory is dropped.
+// Submitting again once memory is back retries whatever failed.
+ReconcileStats SubmitDescription(Window* window);
+
+// A compiled layout file mapped into memory, see CompileLayout
+typedef struct LayoutFile LayoutFile;
+
+// Maps a layout file compiled by compile_layout (make layouts), NULL when it can not be read or is damaged
+LayoutFile* OpenLayoutFile(const char* path);
+// Unmaps the file, only once no window shows its elements anymore
+void CloseLayoutFile(LayoutFile* layout);
+// Creates the elements of the layout in the window's arena and adds them to the window. The records are
+// turned into elements in one pass with three allocations, strings are shown straight from the file.
+// ClearWindow or DestroyWindow removes them.
+int AddLayout(Window* window, const LayoutFile* layout);
+// Compiles a human readable layout into a layout file, see src/common/layoutfile.h for the format
+int CompileLayout(const char* source, const char* destination);
 
 
 #endif
\ No newline at end of file
@@ -19,12 +19,14 @@ int main() {
     }
 
     LoadAssets(window);
+    // Only redraw when something changes instead of spinning a core
+    SetWindowRenderMode(window, RENDER_ON_DEMAND);
 
-    AddText(window,CreateText((Vector2){100,200},"Theo LOVES Oliva",0.80f,(Color){0,0,0}));
+    AddText(window,CreateText((Vector2){100,200},"Theo LOVES Oliva",0.80f,(Color){255,255,255,255}));
 
     while (!WindowShouldClose(window)) {
 
-        FillWindow(window,(Color){20,20,20});
+        FillWindow(window,(Color){20,20,20,255});
 
         UpdateWindow(window);
     }
@@ -0,0 +1,35 @@
+#version 330 core
+in vec2 TexCoords;
+flat in int Kind;
+flat in vec3 Shape;
+flat in vec4 Color;
+out vec4 color;
+
+uniform sampler2D atlas;
+
+// Matches DrawKind in drawlist.h
+const int KIND_GLYPH = 0;
+const int KIND_SOLID = 1;
+const int KIND_ROUNDED_RECT = 2;
+const int KIND_IMAGE = 3;
+
+// TexCoords holds the offset from the rect center in pixels for rounded rects
+float RoundedRectCoverage()
+{
+    vec2 corner = abs(TexCoords) - Shape.xy + Shape.z;
+    float distance = length(max(corner, 0.0)) + min(max(corner.x, corner.y), 0.0) - Shape.z;
+    return clamp(0.5 - distance, 0.0, 1.0);
+}
+
+void main()
+{
+    if (Kind == KIND_GLYPH) {
+        color = Color * vec4(1.0, 1.0, 1.0, texture(atlas, TexCoords).r);
+    } else if (Kind == KIND_ROUNDED_RECT) {
+        color = Color * vec4(1.0, 1.0, 1.0, RoundedRectCoverage());
+    } else if (Kind == KIND_IMAGE) {
+        color = Color * texture(atlas, TexCoords);
+    } else {
+        color = Color;
+    }
+}
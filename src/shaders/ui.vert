@@ -0,0 +1,20 @@
+#version 330 core
+layout (location = 0) in vec4 vertex; // <vec2 pos, vec2 tex>
+layout (location = 1) in float kind;
+layout (location = 2) in vec3 shape;  // <half width, half height, radius> of rounded rects
+layout (location = 3) in vec4 color;  // Normalized from bytes
+out vec2 TexCoords;
+flat out int Kind;
+flat out vec3 Shape;
+flat out vec4 Color;
+
+uniform mat4 projection;
+
+void main()
+{
+    gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
+    TexCoords = vertex.zw;
+    Kind = int(kind + 0.5);
+    Shape = shape;
+    Color = color;
+}
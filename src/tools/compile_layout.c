@@ -0,0 +1,14 @@
+// Compiles human readable layouts into the binary files guilay maps with OpenLayoutFile.
+// Usage: compile_layout input.layout output.glay, see CompileLayout in src/common/layoutfile.h for the format.
+
+#include <stdio.h>
+
+#include "../common/layoutfile.h"
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: compile_layout input.layout output.glay\n");
+        return 1;
+    }
+    return CompileLayout(argv[1], argv[2]);
+}
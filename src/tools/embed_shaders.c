@@ -0,0 +1,69 @@
+// Writes shader files into a C header as string constants so guilay does not read them at runtime.
+// The makefile runs this, usage: embed_shaders output.h shader...
+// src/shaders/ui.vert becomes `static const char ui_vert[]`.
+
+#include <stdio.h>
+#include <string.h>
+
+static void WriteName(FILE* out, const char* path) {
+    const char* name = path;
+    for (const char* c = path; *c; c++) {
+        if (*c == '/' || *c == '\\') name = c + 1;
+    }
+
+    for (const char* c = name; *c; c++) {
+        fputc(*c == '.' || *c == '-' ? '_' : *c, out);
+    }
+}
+
+static int EmbedFile(FILE* out, const char* path) {
+    FILE* in = fopen(path, "rb");
+    if (!in) {
+        fprintf(stderr, "embed_shaders: could not open %s\n", path);
+        return 1;
+    }
+
+    fprintf(out, "static const char ");
+    WriteName(out, path);
+    fprintf(out, "[] =\n    \"");
+
+    int c;
+    while ((c = fgetc(in)) != EOF) {
+        switch (c) {
+            case '\\': fputs("\\\\", out); break;
+            case '"':  fputs("\\\"", out); break;
+            case '\r': break;
+            case '\n': fputs("\\n\"\n    \"", out); break;
+            default:   fputc(c, out); break;
+        }
+    }
+    fprintf(out, "\";\n\n");
+
+    fclose(in);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: embed_shaders output.h shader...\n");
+        return 1;
+    }
+
+    FILE* out = fopen(argv[1], "wb");
+    if (!out) {
+        fprintf(stderr, "embed_shaders: could not write %s\n", argv[1]);
+        return 1;
+    }
+
+    fprintf(out, "// Generated by src/tools/embed_shaders.c from src/shaders, do not edit\n\n");
+    fprintf(out, "#ifndef EMBEDDED_SHADERS_H\n#define EMBEDDED_SHADERS_H\n\n");
+
+    int failed = 0;
+    for (int i = 2; i < argc; i++) failed |= EmbedFile(out, argv[i]);
+
+    fprintf(out, "#endif\n");
+    fclose(out);
+
+    if (failed) remove(argv[1]);
+    return failed;
+}